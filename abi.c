@@ -4,6 +4,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Vectorized kernels are built for x86 with GCC/Clang function-level target attributes,
+// so the rest of the library does not need to be compiled with any special flags. The
+// scalar implementations are always available and are used on other architectures.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ABI_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
 //===============================================
 // HELPERS
 //===============================================
@@ -15,6 +23,10 @@ static uint32_t get_abi_u32_be(const void * in, size_t loc) {
   return inPtr[l-1] | inPtr[l-2] << 8 | inPtr[l-3] << 16 | inPtr[l-4] << 24;
 }
 
+static inline uint32_t read_u32_be(const uint8_t * in) {
+  return (uint32_t) in[3] | (uint32_t) in[2] << 8 | (uint32_t) in[1] << 16 | (uint32_t) in[0] << 24;
+}
+
 static void write_u32_be(void * out, uint32_t n) {
   ((uint8_t*)out)[0] = (uint8_t)((n >> 24) & 0xff);
   ((uint8_t*)out)[1] = (uint8_t)((n >> 16) & 0xff);
@@ -22,6 +34,11 @@ static void write_u32_be(void * out, uint32_t n) {
   ((uint8_t*)out)[3] = (uint8_t)((n >> 0) & 0xff);
 }
 
+static void write_u64_be(uint8_t * out, uint64_t n) {
+  write_u32_be(out, (uint32_t) (n >> 32));
+  write_u32_be(out + 4, (uint32_t) n);
+}
+
 static bool is_fixed_bytes_type(ABI_t t) {
   return t.type >= ABI_BYTES1 && t.type <= ABI_BYTES32;
 }
@@ -157,6 +174,23 @@ static bool tuple_has_fixed_sz_elem_arr(const ABI_t * types, size_t numTypes, si
   return false;
 }
 
+// Get the size of a static param, which is written in place in the head. Static tuples
+// (and fixed size arrays of them) are every word of every element. Returns 0 if the
+// params of a tuple cannot be found.
+static size_t get_static_sz(const ABI_t * types, size_t numTypes, size_t idx) {
+  ABI_t t = types[idx];
+  size_t n = t.isArray ? t.arraySz : 1;
+  if (!is_tuple_type(t))
+    return ABI_WORD_SZ * n;
+  int firstIdx = get_first_tuple_param_idx(types, numTypes, idx);
+  if (firstIdx < 0)
+    return 0;
+  size_t sz = 0;
+  for (size_t i = (size_t) firstIdx; i < (size_t) firstIdx + get_tuple_sz(t); i++)
+    sz += get_static_sz(types, numTypes, i);
+  return n * sz;
+}
+
 // Get the number of bytes describing an elementary data type
 static size_t elem_sz(ABI_t t) {
   if (is_dynamic_atomic_type(t))
@@ -186,22 +220,22 @@ static size_t elem_sz(ABI_t t) {
   }
 }
 
-// Decode a parameter of elementary type. Each elementary type is encoded in a single 32 byte word,
+// Get the width of an elementary value in the packed (`abi.encodePacked`) layout, where values are
+// not padded. This is `elem_sz`, except that signed integers take only their own width.
+static size_t packed_elem_sz(ABI_t t) {
+  if (t.type >= ABI_INT8 && t.type < ABI_INT256)
+    return 32 - (ABI_INT256 - t.type);
+  return elem_sz(t);
+}
+
+// Locate a parameter of elementary type. Each elementary type is encoded in a single 32 byte word,
 // but may contain less data than 32 bytes (depending on the type -- see `elemSz()`).
-static int decode_elem_param( void * out, 
-                              size_t outSz, 
-                              ABI_t type, 
-                              const void * in, 
-                              size_t inSz, 
-                              size_t off) 
+// On success, `dataOff` is set to the offset of the (padding-stripped) data in the input buffer.
+static int locate_elem_param(ABI_t type, size_t inSz, size_t off, size_t * dataOff)
 {
-  // Ensure there is space for this data in `out` and that this is an elementary type
-  if (ABI_WORD_SZ > outSz || is_dynamic_atomic_type(type))
+  if (is_dynamic_atomic_type(type))
     return -1;
   size_t nBytes = elem_sz(type);
-  const uint8_t * inPtr = in;
-  if (outSz < nBytes)
-    return -1;
   // Most types have data written at the end of the word. Start with this assumption. 
   size_t start = off + (ABI_WORD_SZ - nBytes);
   // Non-numerical (and non-bool) types have data written to the beginning of the word
@@ -209,63 +243,63 @@ static int decode_elem_param( void * out,
     start = off;
   if (start + nBytes > inSz)
     return -1;
-  memcpy(out, inPtr + start, nBytes);
+  *dataOff = start;
   return nBytes;
 }
 
-// Decode a parameter of dynamic type. Each dynamic type is prefixed with a word that
+// Locate a parameter of dynamic type. Each dynamic type is prefixed with a word that
 // specifies the size of the item, followed by `N` words worth of data. If the param
 // is not a multiple of 32 bytes, it is right-padded with zeros.
-// We only copy the data itself, i.e. we discard the right-padded zeros.
-static int decode_dynamic_param(  void * out, 
-                                  size_t outSz, 
-                                  ABI_t type, 
-                                  const void * in, 
-                                  size_t inSz, 
-                                  size_t off) {
+// We only locate the data itself, i.e. we discard the right-padded zeros.
+static int locate_dynamic_param(ABI_t type, const void * in, size_t inSz, size_t off, size_t * dataOff)
+{
   if (!is_dynamic_atomic_type(type))
     return -1;
-  const uint8_t * inPtr = in;
   if (off + ABI_WORD_SZ > inSz)
     return -1;
   size_t elemSz = get_abi_u32_be(in, off);
   off += ABI_WORD_SZ;
-  if (outSz < elemSz)
-    return -1;
   if (off + elemSz > inSz)
     return -1;
-  memcpy(out, inPtr + off, elemSz);
+  *dataOff = off;
   return elemSz;
 }
 
-// Decode a param given its offset. The rules for decoding depend on the type of param.
-// The offset provided (`off`) is the starting place of the param itself. 
-static int decode_param(  void * out, 
-                          size_t outSz, 
-                          ABI_t type, 
-                          const void * in, 
-                          size_t inSz, 
-                          size_t off, 
-                          ABISelector_t info) 
+// Locate a param given its offset. The rules for decoding depend on the type of param.
+// The offset provided (`off`) is the starting place of the param itself. On success, 
+// `dataOff` is set to the offset of the param data in `in` and the data size is returned.
+// Nothing is copied, so this is also used by decoders which skip params they do not need.
+static int locate_param(ABI_t type, 
+                        const void * in, 
+                        size_t inSz, 
+                        size_t off, 
+                        ABISelector_t info,
+                        size_t * dataOff) 
 {
-  if (!out || !in)
+  if (!in || !dataOff)
     return -1;
   // Elementary types are fairly straight forward
   if (is_elementary_type_variable_sz_array(type)) {
+    // Sanity check to avoid overrun
+    if (off + ABI_WORD_SZ > inSz)
+      return -1;
     // Variable sized arrays require a jump to the item
     size_t numElem = get_abi_u32_be(in, off);
     if (info.arrIdx >= numElem)
       return -1;
     // Skip the numElem word and jump to the array index
     off += ABI_WORD_SZ * (1 + info.arrIdx);
-    return decode_elem_param(out, outSz, type, in, inSz, off);
+    return locate_elem_param(type, inSz, off, dataOff);
   } else if (is_elementary_atomic_type(type)) {
     // Other elementary types can be decoded without modification
-    return decode_elem_param(out, outSz, type, in, inSz, off);
+    return locate_elem_param(type, inSz, off, dataOff);
   }
   // Dynamic types have prefixes that we need to account for
   if (is_dynamic_type_array(type)) {
     if (is_dynamic_type_fixed_sz_array(type)) {
+      // Sanity check to avoid overrun
+      if (off + (ABI_WORD_SZ * (1 + info.arrIdx)) > inSz)
+        return -1;
       off += get_abi_u32_be(in, off + (ABI_WORD_SZ * info.arrIdx));
     } else {
       // Sanity check to avoid overrun
@@ -277,93 +311,142 @@ static int decode_param(  void * out,
         return -1;
       // Skip past this word
       off += ABI_WORD_SZ;
+      if (off + (ABI_WORD_SZ * (1 + info.arrIdx)) > inSz)
+        return -1;
       // Get the offset for this item and jump to it
       off += get_abi_u32_be(in, off + (ABI_WORD_SZ * info.arrIdx));
     }
   }
   // We should now be at the offset corresponding to the size of the dynamic
   // type element that we want.
-  return decode_dynamic_param(out, outSz, type, in, inSz, off);
+  return locate_dynamic_param(type, in, inSz, off, dataOff);
 }
 
-// Get an offset of the parameter in question. The rules depend on the type of param.
-static size_t get_param_offset( const ABI_t * types, 
-                                size_t numTypes, 
-                                ABISelector_t info, 
-                                const void * in, 
-                                size_t inSz) 
+// Decode a param given its offset, i.e. locate the param and copy its data into `out`.
+static int decode_param(  void * out, 
+                          size_t outSz, 
+                          ABI_t type, 
+                          const void * in, 
+                          size_t inSz, 
+                          size_t off, 
+                          ABISelector_t info) 
 {
-  if (!types || !in)
+  if (!out || !in)
     return -1;
-  ABI_t type = types[info.typeIdx];
-  size_t off = 0;
-  size_t paramOff = 0;
+  // Ensure there is space for a full word if this is an elementary type
+  if (is_elementary_atomic_type(type) && ABI_WORD_SZ > outSz)
+    return -1;
+  size_t dataOff = 0;
+  int nBytes = locate_param(type, in, inSz, off, info, &dataOff);
+  if (nBytes < 0 || (size_t) nBytes > outSz)
+    return -1;
+  memcpy(out, (const uint8_t *) in + dataOff, nBytes);
+  return nBytes;
+}
+
+// Get the size of a param's slot in the header data, which only depends on its type.
+// Returns -1 on error.
+static size_t get_head_slot_sz(const ABI_t * types, size_t numTypes, size_t idx)
+{
+  ABI_t _type = types[idx];
+
+  bool is_tuple_without_dynamic_type_and_not_var_sz_arr = (
+    (is_tuple_type(_type)) &&
+    (!tuple_has_dynamic_type(types, numTypes, idx)) &&
+    (!is_variable_sz_array(_type))
+  );
+
+  bool is_tuple_without_var_array_or_dynamic_params = (
+    (is_tuple_without_dynamic_type_and_not_var_sz_arr) &&
+    (!tuple_has_variable_sz_elem_arr(types, numTypes, idx))
+  );
+
+  bool is_tuple_with_fixed_elem_array_and_not_var_arr = (
+    (is_tuple_without_var_array_or_dynamic_params) &&
+    (tuple_has_fixed_sz_elem_arr(types, numTypes, idx))
+  );
+
+  bool is_non_tuple_fixed_elem_array = (
+    (is_elementary_type_fixed_sz_array(_type)) && 
+    (!is_tuple_type(_type))
+  );
+  if (is_non_tuple_fixed_elem_array) {
+    // Elementary type fixed sz arrays have all params in the header data
+    return ABI_WORD_SZ * _type.arraySz;
+  } else if (is_tuple_with_fixed_elem_array_and_not_var_arr) {
+    // Tuples with fixed arrays and no dynamic params or variable arrays are
+    // not represented by offsets -- they have all their params packed into the
+    // header data.
+    int startIdx = get_first_tuple_param_idx(types, numTypes, idx);
+    if (startIdx < 0)
+      return -1;
+    size_t numWords = 0;
+    for (size_t j = (size_t) startIdx; j < (size_t) startIdx + get_tuple_sz(_type); j++) {
+      if (is_elementary_type_array(types[j]) && is_fixed_sz_array(types[j])) {
+        numWords += types[j].arraySz;
+      } else {
+        numWords++;
+      }
+    }
+    size_t arrMult = 1;
+    if (_type.isArray && _type.arraySz > 0)
+      arrMult = _type.arraySz;
+    return arrMult * numWords * ABI_WORD_SZ;
+  } else if (is_tuple_without_var_array_or_dynamic_params) {
+    // Tuples without dynamic types have all params up front.
+    size_t tsz = get_tuple_sz(_type);
+    return ABI_WORD_SZ * (_type.isArray ? _type.arraySz * tsz : tsz);
+  }
+  // Other types are just words in the header data
+  return ABI_WORD_SZ;
+}
 
+// Get the offset of a param's slot in the header data. This only depends on the params
+// preceding it in the definition, so it does not require any payload data.
+// Returns -1 on error.
+static size_t get_head_offset(const ABI_t * types, size_t numTypes, size_t typeIdx)
+{
+  if (!types)
+    return -1;
+  size_t off = 0;
   // Fixed size elementary type arrays pack everything into the header data, i.e.
   // do not come with an offset to the param. If such a param comes before our target
   // param we need to sufficiently skip over it.
-  for (size_t i = 0; i < info.typeIdx; i++) {
-    // Note the -1, which accounts for the param in this slot. If this was a normal
-    // param it would take up 1 word.
-    ABI_t _type = types[i];
-
-    bool is_tuple_without_dynamic_type_and_not_var_sz_arr = (
-      (is_tuple_type(_type)) &&
-      (!tuple_has_dynamic_type(types, numTypes, i)) &&
-      (!is_variable_sz_array(_type))
-    );
-
-    bool is_tuple_without_var_array_or_dynamic_params = (
-      (is_tuple_without_dynamic_type_and_not_var_sz_arr) &&
-      (!tuple_has_variable_sz_elem_arr(types, numTypes, i))
-    );
-
-    bool is_tuple_with_fixed_elem_array_and_not_var_arr = (
-      (is_tuple_without_var_array_or_dynamic_params) &&
-      (tuple_has_fixed_sz_elem_arr(types, numTypes, i))
-    );
-
-    bool is_non_tuple_fixed_elem_array = (
-      (is_elementary_type_fixed_sz_array(_type)) && 
-      (!is_tuple_type(_type))
-    );
-    if (is_non_tuple_fixed_elem_array) {
-      // Elementary type fixed sz arrays have all params in the header data
-      off += ABI_WORD_SZ * _type.arraySz;
-    } else if (is_tuple_with_fixed_elem_array_and_not_var_arr) {
-      // Tuples with fixed arrays and no dynamic params or variable arrays are
-      // not represented by offsets -- they have all their params packed into the
-      // header data.
-      int startIdx = get_first_tuple_param_idx(types, numTypes, i);
-      if (startIdx < 0)
-        return -1;
-      size_t numWords = 0;
-      for (size_t j = startIdx; j < startIdx + get_tuple_sz(_type); j++) {
-        if (is_elementary_type_array(types[j]) && is_fixed_sz_array(types[j])) {
-          numWords += types[j].arraySz;
-        } else {
-          numWords++;
-        }
-      }
-      size_t arrMult = 1;
-      if (_type.isArray && _type.arraySz > 0)
-        arrMult = _type.arraySz;
-      off += arrMult * numWords * ABI_WORD_SZ;
-    } else if (is_tuple_without_var_array_or_dynamic_params) {
-      // Tuples without dynamic types have all params up front.
-      size_t tsz = get_tuple_sz(_type);
-      off += ABI_WORD_SZ * (_type.isArray ? _type.arraySz * tsz : tsz);
-    } else {
-      // Other types are just words in the header data
-      off += ABI_WORD_SZ;
-    }
+  for (size_t i = 0; i < typeIdx; i++) {
+    size_t sz = get_head_slot_sz(types, numTypes, i);
+    if (sz == (size_t) -1)
+      return -1;
+    off += sz;
   }
+  return off;
+}
+
+// Get an offset of the parameter in question, given the offset of its slot in the header
+// data (see `get_head_offset`). The rules depend on the type of param.
+static size_t get_param_offset_at(const ABI_t * types, 
+                                  size_t numTypes, 
+                                  ABISelector_t info, 
+                                  size_t off,
+                                  const void * in, 
+                                  size_t inSz) 
+{
+  if (!types || !in)
+    return -1;
+  ABI_t type = types[info.typeIdx];
+  size_t paramOff = 0;
+  if (off > inSz)
+    return inSz + 1;
   if ((tuple_has_variable_sz_elem_arr(types, numTypes, info.typeIdx)) && 
       (!tuple_has_dynamic_type(types, numTypes, info.typeIdx)) ) {
+    // Sanity check to avoid overrun
+    if (off + ABI_WORD_SZ > inSz)
+      return inSz + 1;
     paramOff = get_abi_u32_be(in, off);
   } else if (is_dynamic_atomic_type(type) || is_variable_sz_array(type)) {
     // Dynamic types and variable sized arrays of any type are located at 
     // their respective offsets
+    if (off + ABI_WORD_SZ > inSz)
+      return inSz + 1;
     paramOff = get_abi_u32_be(in, off);
   } else {
     // All other parameters are located in the header
@@ -385,14 +468,31 @@ static size_t get_param_offset( const ABI_t * types,
   return paramOff;
 }
 
-// Get the starting index of data for the specified tuple. If the tuple is an array
-// this will be the starting point of the tuple item we want, but NOT the starting
-// point of the tuple's parameter
-size_t get_tuple_data_start(const ABI_t * types, size_t numTypes, ABISelector_t tupleInfo, const void * in, size_t inSz)
+// Get an offset of the parameter in question
+static size_t get_param_offset( const ABI_t * types, 
+                                size_t numTypes, 
+                                ABISelector_t info, 
+                                const void * in, 
+                                size_t inSz) 
+{
+  if (!types || !in)
+    return -1;
+  return get_param_offset_at(types, numTypes, info, get_head_offset(types, numTypes, info.typeIdx), in, inSz);
+}
+
+// Get the starting index of data for the specified tuple, given the offset of its slot in the
+// header data. If the tuple is an array this will be the starting point of the tuple item we
+// want, but NOT the starting point of the tuple's parameter
+static size_t get_tuple_data_start_at(const ABI_t * types, 
+                                      size_t numTypes, 
+                                      ABISelector_t tupleInfo, 
+                                      size_t headOff,
+                                      const void * in, 
+                                      size_t inSz)
 {
   if (!types || !in)
     return -1;
-  size_t dataOff = get_param_offset(types, numTypes, tupleInfo, in, inSz);
+  size_t dataOff = get_param_offset_at(types, numTypes, tupleInfo, headOff, in, inSz);
   if (dataOff > inSz)
     return 0;
   ABI_t tupleType = types[tupleInfo.typeIdx];
@@ -437,225 +537,2809 @@ size_t get_tuple_data_start(const ABI_t * types, size_t numTypes, ABISelector_t
     if (tuple_has_variable_sz_elem_arr(types, numTypes, tupleInfo.typeIdx)) {
       dataOff += get_abi_u32_be(in, dataOff + (tupleInfo.arrIdx * ABI_WORD_SZ)); 
     } else {
-      dataOff += (tupleInfo.arrIdx * get_tuple_sz(tupleType)) * ABI_WORD_SZ;
+      dataOff += tupleInfo.arrIdx * (get_static_sz(types, numTypes, tupleInfo.typeIdx) / tupleType.arraySz);
     }
   }
   return dataOff;
 }
 
-//===============================================
-// API
-//===============================================
-bool is_tuple_type(ABI_t t) {
-  return (t.type <= ABI_TUPLE20 && t.type >= ABI_TUPLE1);
-}
-
-int get_tuple_sz(ABI_t t) {
-  if (!is_tuple_type(t))
-    return -1;
-  return (t.type - ABI_TUPLE1) + 1; 
-}
-
-bool abi_is_valid_schema(const ABI_t * types, size_t numTypes) {
-  if (!types)
-    return false;
-  for (size_t i = 0; i < numTypes; i++) {
-    if ((types[i].type >= ABI_MAX || types[i].type <= ABI_NONE) ||
-        ( (!is_single_elementary_type(types[i])) &&
-          (!is_single_dynamic_type(types[i])) &&
-          (!is_tuple_type(types[i])) &&
-          (!is_elementary_type_fixed_sz_array(types[i])) &&
-          (!is_elementary_type_variable_sz_array(types[i])) &&
-          (!is_dynamic_type_fixed_sz_array(types[i])) &&
-          (!is_dynamic_type_variable_sz_array(types[i])) ))
-      return false;
-  }
-  return true;
-}
-
-int abi_get_array_sz( const ABI_t * types, 
-                      size_t numTypes, 
-                      ABISelector_t info, 
-                      const void * in,
-                      size_t inSz)
+size_t get_tuple_data_start(const ABI_t * types, size_t numTypes, ABISelector_t tupleInfo, const void * in, size_t inSz)
 {
   if (!types || !in)
     return -1;
-  ABI_t type = types[info.typeIdx];
-  if (info.typeIdx >= numTypes || !abi_is_valid_schema(types, numTypes))
-    return -1;
-  // Fixed size arrays have size included
-  if (!is_variable_sz_array(type))
-    return type.arraySz;
-  // Get the offset of this parameter in the function definition
-  size_t paramOff = get_param_offset(types, numTypes, info, in, inSz);
-  if (paramOff > inSz)
-    return -1;
-  // The parameter at `paramOff` contains an offset where the array
-  // data begins. Since the first word in a variable sized array
-  // (which this must be) contains the array size, that's what we need.
-  return get_abi_u32_be(in, paramOff);
+  return get_tuple_data_start_at(types, numTypes, tupleInfo, get_head_offset(types, numTypes, tupleInfo.typeIdx), in, inSz);
 }
 
-int abi_get_tuple_param_array_sz( const ABI_t * types, 
-                                  size_t numTypes, 
-                                  ABISelector_t tupleInfo,
-                                  ABISelector_t paramInfo, 
-                                  const void * in,
-                                  size_t inSz)
+// Get the number of root params in a schema. Params nested in tuples are appended
+// to the end of the `types` array, so these are the first `N` types.
+static size_t get_num_root_types(const ABI_t * types, size_t numTypes) {
+  size_t numNested = 0;
+  for (size_t i = 0; i < numTypes; i++)
+    if (is_tuple_type(types[i]))
+      numNested += get_tuple_sz(types[i]);
+  if (numNested > numTypes)
+    return 0;
+  return numTypes - numNested;
+}
+
+// Get the number of elements in a param. Non-array params have one element, fixed size
+// arrays have their size in the type, and variable size arrays have it encoded in the data.
+// Returns -1 on error.
+static int get_param_num_elems(const ABI_t * types, 
+                                size_t numTypes, 
+                                size_t typeIdx, 
+                                size_t headOff, 
+                                const void * in, 
+                                size_t inSz) 
 {
-  if (!types || !in)
-    return -1;
-  int typeIdx = get_first_tuple_param_idx(types, numTypes, tupleInfo.typeIdx);
-  if (typeIdx < 0)
-    return -1;
-  typeIdx += paramInfo.typeIdx;
   ABI_t type = types[typeIdx];
-  if (typeIdx >= numTypes || !abi_is_valid_schema(types, numTypes))
-    return -1;
-  // Fixed size arrays have size included
-  if (!is_variable_sz_array(type))
+  if (!type.isArray)
+    return 1;
+  if (is_fixed_sz_array(type))
     return type.arraySz;
-  // Update types pointer offset to skip non-tuple types. This allows us to treat
-  // the tuple as its own sort of "nested" definition.
-  int firstTupleParamIdx = get_first_tuple_param_idx(types, numTypes, tupleInfo.typeIdx);
-  if (firstTupleParamIdx < 0)
+  ABISelector_t info = { .typeIdx = typeIdx };
+  size_t paramOff = get_param_offset_at(types, numTypes, info, headOff, in, inSz);
+  if (paramOff > inSz || paramOff + ABI_WORD_SZ > inSz)
     return -1;
-  const ABI_t * tupleTypes = types + firstTupleParamIdx;
-  // Get the offset at which the tuple data starts
-  size_t dataOff = get_tuple_data_start(types, numTypes, tupleInfo, in, inSz);
-  // Jump to the start of our tuple item
-  in += dataOff;
-  inSz -= dataOff;
-  size_t paramOff = get_param_offset(tupleTypes, (numTypes - firstTupleParamIdx), paramInfo, in, inSz);
   return get_abi_u32_be(in, paramOff);
 }
 
-int abi_decode_param( void * out, 
-                      size_t outSz, 
-                      const ABI_t * types, 
-                      size_t numTypes, 
-                      ABISelector_t info, 
-                      const void * in,
-                      size_t inSz) 
+// Locate every element of an elementary type array. Elements are stored in consecutive words,
+// so the array is described by the offset of its first word and its number of elements.
+// Returns the number of elements; -1 on error.
+static int locate_elem_array( const ABI_t * types, 
+                              size_t numTypes, 
+                              size_t typeIdx, 
+                              const void * in, 
+                              size_t inSz, 
+                              size_t * wordsOff)
 {
-  if (!out || !types || !in)
-    return -1;
-  // Ensure we have valid types passed
-  if ((info.typeIdx >= numTypes) ||
-      (!abi_is_valid_schema(types, numTypes)))
+  ABI_t type = types[typeIdx];
+  if (!is_elementary_type_array(type))
     return -1;
+  ABISelector_t info = { .typeIdx = typeIdx };
   size_t paramOff = get_param_offset(types, numTypes, info, in, inSz);
   if (paramOff > inSz)
     return -1;
-  return decode_param(out, outSz, types[info.typeIdx], in, inSz, paramOff, info);
+  size_t numElems = type.arraySz;
+  if (is_variable_sz_array(type)) {
+    // Skip the word containing the array size
+    if (paramOff + ABI_WORD_SZ > inSz)
+      return -1;
+    numElems = get_abi_u32_be(in, paramOff);
+    paramOff += ABI_WORD_SZ;
+  }
+  // Sanity check to avoid overrun
+  if (numElems > (inSz - paramOff) / ABI_WORD_SZ || numElems > INT32_MAX)
+    return -1;
+  *wordsOff = paramOff;
+  return numElems;
 }
 
-int abi_decode_tuple_param( void * out, 
-                            size_t outSz, 
-                            const ABI_t * types, 
-                            size_t numTypes,
-                            ABISelector_t tupleInfo,
-                            ABISelector_t paramInfo, 
-                            const void * in,
-                            size_t inSz) 
-{
-  if (!out || !types || !in)
-    return -1;
-  // Ensure we have valid types passed
-  if (tupleInfo.typeIdx >= numTypes || !abi_is_valid_schema(types, numTypes))
-    return -1;
-  ABI_t tupleType = types[tupleInfo.typeIdx];
-  size_t tupleTypeSz = get_tuple_sz(tupleType);
-  // Sanity check: ensure this is a tuple type
-  if (!is_tuple_type(tupleType))
-    return -1;
-  // Sanity check: ensure we won't overrun our buffer
-  if (paramInfo.typeIdx > tupleTypeSz || paramInfo.typeIdx > numTypes)
-    return -1;
-  // Update types pointer offset to skip non-tuple types. This allows us to treat
-  // the tuple as its own sort of "nested" definition.
-  int paramIdx = get_first_tuple_param_idx(types, numTypes, tupleInfo.typeIdx);
-  if (paramIdx < 0)
-    return -1;
-  const ABI_t * tupleTypes = types + paramIdx;
+// Signed integer types are two's complement in the ABI, i.e. negative values
+// are left-padded with 0xff rather than zeros.
+static bool is_signed_int_type(ABI_t t) {
+  return (t.type >= ABI_INT8 && t.type <= ABI_INT256) || t.type == ABI_INT;
+}
 
-  // Get the offset at which the tuple data starts
-  size_t dataOff = get_tuple_data_start(types, numTypes, tupleInfo, in, inSz);
-  // Jump to the start of our tuple item
-  in += dataOff;
-  inSz -= dataOff;
-  return abi_decode_param(out, 
-                          outSz, 
-                          tupleTypes, 
-                          tupleTypeSz,
-                          paramInfo,
-                          in,
-                          inSz);
+// Whether a param is decoded as a byte swapped number, i.e. it is an integer, native endian
+// output was requested, and this is a little endian host.
+static bool is_swapped(ABI_t t, uint32_t flags) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  return false;
+#else
+  return (flags & ABI_DECODE_NATIVE_ENDIAN) && 
+         ((t.type >= ABI_UINT8 && t.type <= ABI_INT256) || t.type == ABI_UINT || t.type == ABI_INT);
+#endif
 }
 
-int abi_encode( void * out, 
-                size_t outSz, 
-                const ABI_t * types, 
-                size_t numTypes, 
-                size_t * offsets, 
-                const void * in, 
-                size_t inSz)
-{
-  while (!out || !types || !in);
-  if (numTypes == 0 || outSz == 0 || inSz == 0 || (!abi_is_valid_schema(types, numTypes)))
-    return -1;
-  size_t numWritten = 0;
-  size_t dynamicCount = 0;
-  for (size_t i = 0; i < numTypes; i++) {
-    void * loc = out + (ABI_WORD_SZ * i);
+static void swap_words(uint8_t * out, const uint8_t * words, size_t numWords, size_t sz);
 
-    // TODO: Expand coverage beyond simplisitc types (if demand requires it)
-    // Sanity check on the type -- make sure it is allowed
-    if (is_tuple_type(types[i]) || types[i].isArray)
-      return -1;
+// Description of the padding of an elementary type's word. The padding bits of a
+// canonical word are selected by `mask` and are all zero, or all one for negative
+// signed integers (i.e. copies of the sign bit of byte `signIdx`).
+typedef struct {
+  uint8_t mask[ABI_WORD_SZ];
+  bool isSigned;
+  size_t signIdx;
+} ABIPadding_t;
 
-    // Get the size of the data
-    size_t _sz = 0;
-    size_t _off = offsets[i];
-    if (i < numTypes - 1) {
-      if (offsets[i+1] <= _off) // Ensure offsets increase monotonically
+static bool check_padding(const uint8_t * words, size_t numWords, const ABIPadding_t * pad);
+
+static void get_elem_padding(ABI_t type, ABIPadding_t * pad) {
+  memset(pad, 0, sizeof(ABIPadding_t));
+  if (is_fixed_bytes_type(type)) {
+    // Data is written at the start of the word
+    size_t sz = elem_sz(type);
+    memset(pad->mask + sz, 0xff, ABI_WORD_SZ - sz);
+    return;
+  }
+  if (is_signed_int_type(type)) {
+    // Signed integers are always decoded as full words (see `elem_sz`), but
+    // only the bytes below the type's size are data
+    size_t sz = (type.type >= ABI_INT256) ? ABI_WORD_SZ : 1 + (type.type - ABI_INT8);
+    memset(pad->mask, 0xff, ABI_WORD_SZ - sz);
+    pad->isSigned = true;
+    pad->signIdx = ABI_WORD_SZ - sz;
+    return;
+  }
+  memset(pad->mask, 0xff, ABI_WORD_SZ - elem_sz(type));
+  // Bools may only be 0 or 1
+  if (type.type == ABI_BOOL)
+    pad->mask[ABI_WORD_SZ - 1] = 0xfe;
+}
+
+// Check that a located param (see `locate_param`) is canonically padded. Elementary types must be
+// padded to a full word, as described by `pad` (see `get_elem_padding`). Dynamic types must have a
+// canonical size word and be right-padded with zeros to a multiple of 32 bytes, which must be
+// present in the payload.
+static bool has_canonical_padding(ABI_t type, 
+                                  const ABIPadding_t * pad, 
+                                  const uint8_t * in, 
+                                  size_t inSz, 
+                                  size_t dataOff, 
+                                  size_t sz)
+{
+  if (!is_dynamic_atomic_type(type)) {
+    size_t wordOff = is_fixed_bytes_type(type) ? dataOff : dataOff + sz - ABI_WORD_SZ;
+    return check_padding(in + wordOff, 1, pad);
+  }
+  // The size word precedes the data and is read as a 32-bit number
+  ABIPadding_t tailPad;
+  get_elem_padding((ABI_t) { .type = ABI_UINT32 }, &tailPad);
+  if (dataOff < ABI_WORD_SZ || !check_padding(in + dataOff - ABI_WORD_SZ, 1, &tailPad))
+    return false;
+  size_t tailSz = sz % ABI_WORD_SZ;
+  if (tailSz == 0)
+    return true;
+  size_t lastWordOff = dataOff + sz - tailSz;
+  if (lastWordOff + ABI_WORD_SZ > inSz)
+    return false;
+  memset(&tailPad, 0, sizeof(tailPad));
+  memset(tailPad.mask + tailSz, 0xff, ABI_WORD_SZ - tailSz);
+  return check_padding(in + lastWordOff, 1, &tailPad);
+}
+
+// State shared by the walk decoders as they fill the caller's buffers.
+typedef struct {
+  uint8_t * out;
+  size_t outSz;
+  size_t outOff;
+  ABIItem_t * items;
+  size_t numItems;
+  size_t itemOff;
+  uint32_t flags;                     // `ABIDecodeFlags_t` options
+} ABIWalkCtx_t;
+
+static inline bool is_projected(const bool * projection, size_t typeIdx) {
+  return !projection || projection[typeIdx];
+}
+
+// Copy a located param into the walk output buffer and record it as an item. Swapped numbers
+// are read from the end of their word (see `swap_words`).
+// Without an output buffer we are only validating the payload, so nothing is written.
+static bool walk_emit(ABIWalkCtx_t * ctx, ABIItem_t item, const uint8_t * data, bool swap) {
+  if (!ctx->out)
+    return true;
+  if (ctx->itemOff >= ctx->numItems || ctx->outOff + item.sz > ctx->outSz)
+    return false;
+  if (swap)
+    swap_words(ctx->out + ctx->outOff, data + item.sz - ABI_WORD_SZ, 1, item.sz);
+  else
+    memcpy(ctx->out + ctx->outOff, data, item.sz);
+  item.off = ctx->outOff;
+  ctx->items[ctx->itemOff++] = item;
+  ctx->outOff += item.sz;
+  return true;
+}
+
+// Decode every element of a single param, whose slot in the header data is at `headOff`.
+// `types` is either the full definition or, for params nested in a tuple, the tuple's
+// params with `in` pointing to the tuple item.
+static bool walk_param( ABIWalkCtx_t * ctx, 
+                        ABIItem_t item, 
+                        const ABI_t * types, 
+                        size_t numTypes, 
+                        size_t idx, 
+                        size_t headOff,
+                        const uint8_t * in, 
+                        size_t inSz)
+{
+  int numElems = get_param_num_elems(types, numTypes, idx, headOff, in, inSz);
+  if (numElems < 0)
+    return false;
+  bool strict = ctx->flags & ABI_DECODE_STRICT;
+  bool swap = is_swapped(types[idx], ctx->flags);
+  ABIPadding_t pad;
+  if (strict && !is_dynamic_atomic_type(types[idx]))
+    get_elem_padding(types[idx], &pad);
+  for (int i = 0; i < numElems; i++) {
+    ABISelector_t info = { .typeIdx = idx, .arrIdx = i };
+    size_t paramOff = get_param_offset_at(types, numTypes, info, headOff, in, inSz);
+    if (paramOff > inSz)
+      return false;
+    size_t dataOff = 0;
+    int sz = locate_param(types[idx], in, inSz, paramOff, info, &dataOff);
+    if (sz < 0)
+      return false;
+    if (strict && !has_canonical_padding(types[idx], &pad, in, inSz, dataOff, sz))
+      return false;
+    item.info = info;
+    item.sz = sz;
+    if (!walk_emit(ctx, item, in + dataOff, swap))
+      return false;
+  }
+  return true;
+}
+
+// Decode all projected params of a single payload. Params that are not projected
+// are never touched, i.e. we only read the offsets required to reach projected params.
+// The head offset of each param is carried along, so the payload is walked in one pass.
+static bool walk_payload( ABIWalkCtx_t * ctx, 
+                          const ABI_t * types, 
+                          size_t numTypes, 
+                          const bool * projection, 
+                          const uint8_t * in, 
+                          size_t inSz, 
+                          size_t payloadIdx) 
+{
+  size_t numRoot = get_num_root_types(types, numTypes);
+  size_t headOff = 0;
+  for (size_t i = 0; i < numRoot; i++) {
+    size_t slotSz = get_head_slot_sz(types, numTypes, i);
+    if (slotSz == (size_t) -1)
+      return false;
+    size_t off = headOff;
+    headOff += slotSz;
+    ABIItem_t item = { .payloadIdx = payloadIdx, .typeIdx = i };
+    if (!is_tuple_type(types[i])) {
+      if (is_projected(projection, i) && !walk_param(ctx, item, types, numTypes, i, off, in, inSz))
+        return false;
+      continue;
+    }
+    // Projecting a tuple projects all of its params. Otherwise we only need to
+    // visit the tuple if at least one of its params is projected.
+    int firstIdx = get_first_tuple_param_idx(types, numTypes, i);
+    int tupleSz = get_tuple_sz(types[i]);
+    if (firstIdx < 0 || tupleSz < 0)
+      return false;
+    bool hasProjected = is_projected(projection, i);
+    for (int j = 0; j < tupleSz && !hasProjected; j++)
+      hasProjected = is_projected(projection, firstIdx + j);
+    if (!hasProjected)
+      continue;
+    int numTuples = get_param_num_elems(types, numTypes, i, off, in, inSz);
+    if (numTuples < 0)
+      return false;
+    const ABI_t * tupleTypes = types + firstIdx;
+    for (int k = 0; k < numTuples; k++) {
+      ABISelector_t tupleInfo = { .typeIdx = i, .arrIdx = k };
+      size_t dataOff = get_tuple_data_start_at(types, numTypes, tupleInfo, off, in, inSz);
+      if (dataOff > inSz)
+        return false;
+      size_t tupleHeadOff = 0;
+      for (int j = 0; j < tupleSz; j++) {
+        size_t tupleSlotSz = get_head_slot_sz(tupleTypes, tupleSz, j);
+        if (tupleSlotSz == (size_t) -1)
+          return false;
+        size_t paramOff = tupleHeadOff;
+        tupleHeadOff += tupleSlotSz;
+        if (!is_projected(projection, i) && !is_projected(projection, firstIdx + j))
+          continue;
+        item.typeIdx = firstIdx + j;
+        item.isTupleParam = true;
+        item.tupleInfo = tupleInfo;
+        if (!walk_param(ctx, item, tupleTypes, tupleSz, j, paramOff, in + dataOff, inSz - dataOff))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Walk the `payloadIdx`th payload of a batch (NULL if it could not be read). Anything written
+// for a payload that could not be decoded is discarded, and its number of items (or -1) is
+// recorded in `counts` if given.
+static void decode_batch_payload( ABIWalkCtx_t * ctx,
+                                  const ABI_t * types,
+                                  size_t numTypes,
+                                  const bool * projection,
+                                  const uint8_t * in,
+                                  size_t inSz,
+                                  size_t payloadIdx,
+                                  int * counts)
+{
+  size_t outOff = ctx->outOff;
+  size_t itemOff = ctx->itemOff;
+  bool ok = (in != NULL) && walk_payload(ctx, types, numTypes, projection, in, inSz, payloadIdx);
+  if (!ok) {
+    ctx->outOff = outOff;
+    ctx->itemOff = itemOff;
+  }
+  if (counts)
+    counts[payloadIdx] = ok ? (int) (ctx->itemOff - itemOff) : -1;
+}
+
+// Check that an elementary value (in the same format returned by `abi_decode_param`, i.e.
+// without padding) fits in its type.
+static bool elem_value_fits(ABI_t type, const void * val, size_t valSz) {
+  if (!is_elementary_atomic_type(type) || valSz > elem_sz(type))
+    return false;
+  const uint8_t * v = val;
+  // Signed values may be given sign extended past their width (e.g. as a whole word), in which case
+  // the extra bytes must be the sign extension. Bools must be 0 or 1.
+  size_t w = packed_elem_sz(type);
+  for (size_t i = 0; !is_fixed_bytes_type(type) && valSz > w && i < valSz - w; i++)
+    if (v[i] != ((v[valSz - w] & 0x80) ? 0xff : 0))
+      return false;
+  if (type.type == ABI_BOOL && valSz > 0 && v[0] > 1)
+    return false;
+  return true;
+}
+
+// Write a single elementary value into its padded 32 byte word. Returns false if the value
+// does not fit in the type (see `elem_value_fits`).
+static bool encode_elem_word(uint8_t * word, ABI_t type, const void * val, size_t valSz) {
+  if (!elem_value_fits(type, val, valSz))
+    return false;
+  const uint8_t * v = val;
+  uint8_t pad = 0;
+  if (is_signed_int_type(type) && valSz > 0 && (v[0] & 0x80))
+    pad = 0xff;
+  memset(word, pad, ABI_WORD_SZ);
+  if (is_fixed_bytes_type(type))
+    memcpy(word, val, valSz);
+  else
+    memcpy(word + ABI_WORD_SZ - valSz, val, valSz);
+  return true;
+}
+
+// Write a size or offset into its 32 byte word
+static bool encode_u32_word(uint8_t * word, size_t n) {
+  if (n > UINT32_MAX)
+    return false;
+  memset(word, 0, ABI_WORD_SZ);
+  write_u32_be(word + ABI_WORD_SZ - 4, (uint32_t) n);
+  return true;
+}
+
+// Write `bytes` or `string` data as a size word followed by the data, right-padded to a
+// whole number of words. `out` must have room for `1 + ceil(sz / 32)` words.
+static size_t encode_dynamic_data(uint8_t * out, const uint8_t * data, size_t sz) {
+  size_t numWords = 1 + ((sz + ABI_WORD_SZ - 1) / ABI_WORD_SZ);
+  encode_u32_word(out, sz);
+  memset(out + (ABI_WORD_SZ * (numWords - 1)), 0, ABI_WORD_SZ);
+  memcpy(out + ABI_WORD_SZ, data, sz);
+  return ABI_WORD_SZ * numWords;
+}
+
+// Get the number of values in `data` which are each prefixed by their 4-byte big endian
+// size (e.g. the elements of an array of dynamic types). Returns false if the framing is invalid.
+static bool get_framed_count(const uint8_t * data, size_t dataSz, size_t * count) {
+  *count = 0;
+  size_t pos = 0;
+  while (pos < dataSz) {
+    if (dataSz - pos < 4)
+      return false;
+    size_t sz = read_u32_be(data + pos);
+    if (sz > dataSz - pos - 4)
+      return false;
+    pos += 4 + sz;
+    (*count)++;
+  }
+  return true;
+}
+
+// Get the next element of an array value (or param of a tuple value) after `*pos`. Values are
+// either `ABIValue_t` descriptors (`isDesc`), whose `ptr` lists `len` element descriptors, or
+// bytes in the `abi_encode` input format: packed elements of `esz` bytes, or framed elements
+// (`esz == 0`) as counted by `get_framed_count`.
+static bool next_elem(const void * data,
+                      size_t sz,
+                      bool isDesc,
+                      size_t esz,
+                      size_t * pos,
+                      const uint8_t ** elem,
+                      size_t * elemSz)
+{
+  if (isDesc) {
+    if (*pos >= sz)
+      return false;
+    const ABIValue_t * v = (const ABIValue_t *) data + (*pos)++;
+    if (!v->ptr && v->len > 0)
+      return false;
+    *elem = v->ptr;
+    *elemSz = v->len;
+    return true;
+  }
+  const uint8_t * bytes = data;
+  if (esz > 0) {
+    if (sz - *pos < esz)
+      return false;
+    *elemSz = esz;
+  } else {
+    if (sz - *pos < 4 || read_u32_be(bytes + *pos) > sz - *pos - 4)
+      return false;
+    *elemSz = read_u32_be(bytes + *pos);
+    *pos += 4;
+  }
+  *elem = bytes + *pos;
+  *pos += *elemSz;
+  return true;
+}
+
+// Get the number of elements in an array value (see `next_elem`)
+static bool get_elem_count(const void * data, size_t sz, bool isDesc, size_t esz, size_t * count) {
+  if (isDesc) {
+    *count = sz;
+    return (data || sz == 0);
+  } else if (esz > 0) {
+    *count = sz / esz;
+    return (sz % esz == 0);
+  }
+  return get_framed_count(data, sz, count);
+}
+
+// A param is dynamic (i.e. represented by an offset in the head) if it is `bytes`, `string`,
+// a variable size array, or a tuple containing any of those.
+static bool is_dynamic_param(const ABI_t * types, size_t numTypes, size_t idx) {
+  ABI_t t = types[idx];
+  return (is_dynamic_atomic_type(t) || is_variable_sz_array(t) ||
+          tuple_has_dynamic_type(types, numTypes, idx) ||
+          tuple_has_variable_sz_elem_arr(types, numTypes, idx));
+}
+
+// Get the size of a param's head: its value if static, else an offset word
+static size_t get_param_head_sz(const ABI_t * types, size_t numTypes, size_t idx) {
+  return is_dynamic_param(types, numTypes, idx) ? ABI_WORD_SZ : get_static_sz(types, numTypes, idx);
+}
+
+// Get the size of the head of `numParams` consecutive params starting at `firstIdx`
+static size_t get_params_head_sz(const ABI_t * types, size_t numTypes, size_t firstIdx, size_t numParams) {
+  size_t sz = 0;
+  for (size_t i = firstIdx; i < firstIdx + numParams; i++)
+    sz += get_param_head_sz(types, numTypes, i);
+  return sz;
+}
+
+// Elements of arrays of dynamic types and of dynamic tuples are located by a table of offsets
+// (relative to the start of the table); other elements are packed back to back.
+static bool has_offset_table(const ABI_t * types, size_t numTypes, size_t idx) {
+  ABI_t t = types[idx];
+  if (is_tuple_type(t))
+    return (tuple_has_dynamic_type(types, numTypes, idx) ||
+            tuple_has_variable_sz_elem_arr(types, numTypes, idx));
+  return is_dynamic_atomic_type(t);
+}
+
+// Packed (non-descriptor) arrays of elementary types hold elements of a fixed size; the
+// elements of other arrays are framed.
+static size_t get_packed_elem_sz(ABI_t type, bool isDesc) {
+  if (isDesc || is_tuple_type(type) || is_dynamic_atomic_type(type))
+    return 0;
+  return elem_sz(type);
+}
+
+// Get the value of the `i`th of `numParams` params passed to `encode_params`: from its offset
+// to the next one if `offsets` is given, else the next element of `in` (see `next_elem`).
+static bool get_param_value(size_t i,
+                            size_t numParams,
+                            const size_t * offsets,
+                            const void * in,
+                            size_t inSz,
+                            bool isDesc,
+                            size_t * pos,
+                            const uint8_t ** data,
+                            size_t * sz)
+{
+  if (!offsets)
+    return next_elem(in, inSz, isDesc, 0, pos, data, sz);
+  size_t end = (i < numParams - 1) ? offsets[i+1] : inSz;
+  if (end < offsets[i] || end > inSz)
+    return false;
+  *data = (const uint8_t *) in + offsets[i];
+  *sz = end - offsets[i];
+  return true;
+}
+
+static int encode_params(uint8_t * out,
+                         size_t outSz,
+                         const ABI_t * types,
+                         size_t numTypes,
+                         size_t firstIdx,
+                         size_t numParams,
+                         const size_t * offsets,
+                         const void * in,
+                         size_t inSz,
+                         bool isDesc);
+
+// Encode one value of a tuple (its params as elements, see `next_elem`) as if it were its
+// own definition. Returns the number of bytes written; -1 on error.
+static int encode_tuple(uint8_t * out,
+                        size_t outSz,
+                        const ABI_t * types,
+                        size_t numTypes,
+                        size_t idx,
+                        const void * data,
+                        size_t sz,
+                        bool isDesc)
+{
+  int firstIdx = get_first_tuple_param_idx(types, numTypes, idx);
+  if (firstIdx < 0)
+    return -1;
+  return encode_params(out, outSz, types, numTypes, firstIdx, get_tuple_sz(types[idx]), NULL, data, sz, isDesc);
+}
+
+// Encode a single elementary or dynamic value (i.e. not an array or tuple).
+// Returns the number of bytes written; -1 on error.
+static int encode_elem(uint8_t * out, size_t outSz, ABI_t type, const uint8_t * data, size_t sz) {
+  if (is_dynamic_atomic_type(type)) {
+    // Size word followed by the data, right-padded to a whole number of words
+    size_t numWords = 1 + ((sz + ABI_WORD_SZ - 1) / ABI_WORD_SZ);
+    if (numWords > outSz / ABI_WORD_SZ)
+      return -1;
+    return encode_dynamic_data(out, data, sz);
+  }
+  if (sz == 0 || outSz < ABI_WORD_SZ || !encode_elem_word(out, type, data, sz))
+    return -1;
+  return ABI_WORD_SZ;
+}
+
+// Encode a param's value (see `next_elem`) at `out`. For static params this is what goes in
+// the head; for dynamic params it is the data their head offset points to. Arrays are written
+// in one forward pass: element offsets are a running sum of the encoded element sizes.
+// Returns the number of bytes written; -1 on error.
+static int encode_value(uint8_t * out,
+                        size_t outSz,
+                        const ABI_t * types,
+                        size_t numTypes,
+                        size_t idx,
+                        const void * data,
+                        size_t sz,
+                        bool isDesc)
+{
+  ABI_t type = types[idx];
+  if (!type.isArray && is_tuple_type(type))
+    return encode_tuple(out, outSz, types, numTypes, idx, data, sz, isDesc);
+  else if (!type.isArray)
+    return encode_elem(out, outSz, type, data, sz);
+  size_t esz = get_packed_elem_sz(type, isDesc);
+  size_t count;
+  if (!get_elem_count(data, sz, isDesc, esz, &count))
+    return -1;
+  if (is_fixed_sz_array(type) && count != type.arraySz)
+    return -1;
+  // Variable size arrays start with a length word
+  bool hasTable = has_offset_table(types, numTypes, idx);
+  size_t lenSz = is_variable_sz_array(type) ? ABI_WORD_SZ : 0;
+  if (lenSz > outSz || count > (outSz - lenSz) / ABI_WORD_SZ)
+    return -1;
+  size_t pos = lenSz + (hasTable ? ABI_WORD_SZ * count : 0);
+  if (lenSz > 0 && !encode_u32_word(out, count))
+    return -1;
+  size_t inPos = 0;
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t * elem;
+    size_t elemSz;
+    if (!next_elem(data, sz, isDesc, esz, &inPos, &elem, &elemSz))
+      return -1;
+    if (hasTable && !encode_u32_word(out + lenSz + (ABI_WORD_SZ * i), pos - lenSz))
+      return -1;
+    int n = is_tuple_type(type) ? encode_tuple(out + pos, outSz - pos, types, numTypes, idx, elem, elemSz, isDesc) :
+                                  encode_elem(out + pos, outSz - pos, type, elem, elemSz);
+    if (n < 0)
+      return -1;
+    pos += n;
+  }
+  return pos;
+}
+
+// Encode `numParams` consecutive params of the schema starting at `firstIdx` (the root params
+// or the params of a tuple) as a head followed by a tail of dynamic data, in one forward pass.
+// Each value runs from `offsets[i]` to the next offset (or the end of `in`); if `offsets` is
+// NULL the values are instead the elements of `in` (see `next_elem`) and must fill it exactly.
+// Returns the number of bytes written; -1 on error.
+static int encode_params(uint8_t * out,
+                         size_t outSz,
+                         const ABI_t * types,
+                         size_t numTypes,
+                         size_t firstIdx,
+                         size_t numParams,
+                         const size_t * offsets,
+                         const void * in,
+                         size_t inSz,
+                         bool isDesc)
+{
+  size_t headOff = 0;
+  size_t tailOff = get_params_head_sz(types, numTypes, firstIdx, numParams);
+  if (tailOff > outSz)
+    return -1;
+  size_t pos = 0;
+  for (size_t i = 0; i < numParams; i++) {
+    size_t idx = firstIdx + i;
+    const uint8_t * data;
+    size_t sz;
+    if (!get_param_value(i, numParams, offsets, in, inSz, isDesc, &pos, &data, &sz))
+      return -1;
+    if (is_dynamic_param(types, numTypes, idx)) {
+      int n = encode_value(out + tailOff, outSz - tailOff, types, numTypes, idx, data, sz, isDesc);
+      if (n < 0 || !encode_u32_word(out + headOff, tailOff))
+        return -1;
+      headOff += ABI_WORD_SZ;
+      tailOff += n;
+    } else {
+      int n = encode_value(out + headOff, tailOff - headOff, types, numTypes, idx, data, sz, isDesc);
+      if (n < 0)
+        return -1;
+      headOff += n;
+    }
+  }
+  if (!offsets && pos != inSz)
+    return -1;
+  return tailOff;
+}
+
+static bool get_params_enc_sz(const ABI_t * types,
+                              size_t numTypes,
+                              size_t firstIdx,
+                              size_t numParams,
+                              const size_t * offsets,
+                              const void * in,
+                              size_t inSz,
+                              bool isDesc,
+                              size_t * encSz);
+
+// Get the number of bytes `encode_elem` writes for a value, applying the same checks to it
+static bool get_elem_enc_sz(ABI_t type, const uint8_t * data, size_t sz, size_t * encSz) {
+  if (is_dynamic_atomic_type(type)) {
+    *encSz = ABI_WORD_SZ * (1 + ((sz + ABI_WORD_SZ - 1) / ABI_WORD_SZ));
+    return true;
+  }
+  *encSz = ABI_WORD_SZ;
+  return (sz > 0 && elem_value_fits(type, data, sz));
+}
+
+// Get the number of bytes `encode_value` writes for a value, applying the same checks to
+// it but without writing anything. Returns false if the value is invalid.
+static bool get_value_enc_sz(const ABI_t * types,
+                             size_t numTypes,
+                             size_t idx,
+                             const void * data,
+                             size_t sz,
+                             bool isDesc,
+                             size_t * encSz)
+{
+  ABI_t type = types[idx];
+  int firstIdx = is_tuple_type(type) ? get_first_tuple_param_idx(types, numTypes, idx) : 0;
+  if (firstIdx < 0)
+    return false;
+  if (!type.isArray && is_tuple_type(type))
+    return get_params_enc_sz(types, numTypes, firstIdx, get_tuple_sz(type), NULL, data, sz, isDesc, encSz);
+  else if (!type.isArray)
+    return get_elem_enc_sz(type, data, sz, encSz);
+  size_t esz = get_packed_elem_sz(type, isDesc);
+  size_t count;
+  if (!get_elem_count(data, sz, isDesc, esz, &count))
+    return false;
+  if (is_fixed_sz_array(type) && count != type.arraySz)
+    return false;
+  *encSz = (is_variable_sz_array(type) ? ABI_WORD_SZ : 0) + 
+           (has_offset_table(types, numTypes, idx) ? ABI_WORD_SZ * count : 0);
+  size_t inPos = 0;
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t * elem;
+    size_t elemSz, elemEncSz;
+    if (!next_elem(data, sz, isDesc, esz, &inPos, &elem, &elemSz))
+      return false;
+    bool ok = is_tuple_type(type) ? 
+              get_params_enc_sz(types, numTypes, firstIdx, get_tuple_sz(type), NULL, elem, elemSz, isDesc, &elemEncSz) :
+              get_elem_enc_sz(type, elem, elemSz, &elemEncSz);
+    if (!ok)
+      return false;
+    *encSz += elemEncSz;
+  }
+  return true;
+}
+
+// Get the number of bytes `encode_params` writes for a list of params. This is one step per
+// param and per array element, since elementary values are checked to fit but not copied.
+static bool get_params_enc_sz(const ABI_t * types,
+                              size_t numTypes,
+                              size_t firstIdx,
+                              size_t numParams,
+                              const size_t * offsets,
+                              const void * in,
+                              size_t inSz,
+                              bool isDesc,
+                              size_t * encSz)
+{
+  *encSz = 0;
+  size_t pos = 0;
+  for (size_t i = 0; i < numParams; i++) {
+    size_t idx = firstIdx + i;
+    const uint8_t * data;
+    size_t sz, valSz;
+    if (!get_param_value(i, numParams, offsets, in, inSz, isDesc, &pos, &data, &sz))
+      return false;
+    if (!get_value_enc_sz(types, numTypes, idx, data, sz, isDesc, &valSz))
+      return false;
+    // Dynamic values take an offset word in the head as well
+    *encSz += valSz + (is_dynamic_param(types, numTypes, idx) ? ABI_WORD_SZ : 0);
+  }
+  return offsets || pos == inSz;
+}
+
+// Get the number of root params of a schema `abi_encode` can handle, or 0 if it cannot
+static size_t get_encodable_root_types(const ABI_t * types, size_t numTypes) {
+  if (numTypes == 0 || !abi_is_valid_schema(types, numTypes))
+    return 0;
+  // Params nested in tuples must be elementary, dynamic or array types
+  size_t numRoot = get_num_root_types(types, numTypes);
+  for (size_t i = numRoot; i < numTypes; i++)
+    if (is_tuple_type(types[i]))
+      return 0;
+  return numRoot;
+}
+
+// Move the offset word at `off` (relative to `base`) if it points at or past `tailEnd`, i.e.
+// at data after a value which changed size. Used when patching a payload in place.
+static bool shift_offset(uint8_t * data, size_t off, size_t base, size_t tailEnd, size_t grown, size_t shrunk) {
+  size_t o = get_abi_u32_be(data, off);
+  if (base + o < tailEnd)
+    return true;
+  return encode_u32_word(data + off, o + grown - shrunk);
+}
+
+// Get the size of a param in the packed layout. Elementary values take their packed width and the
+// elements of arrays are padded to whole words. `bytes`, `string` and variable size arrays have no
+// size prefix, so their size depends on the value (0 is returned).
+static size_t get_packed_param_sz(ABI_t t) {
+  if (t.isArray)
+    return ABI_WORD_SZ * t.arraySz;
+  return packed_elem_sz(t);
+}
+
+// Tuples and arrays of dynamic types have no packed encoding
+static bool is_packable_schema(const ABI_t * types, size_t numTypes) {
+  if (!types || numTypes == 0 || !abi_is_valid_schema(types, numTypes))
+    return false;
+  for (size_t i = 0; i < numTypes; i++)
+    if (is_tuple_type(types[i]) || (types[i].isArray && is_dynamic_atomic_type(types[i])))
+      return false;
+  return true;
+}
+
+// Write an elementary value at its packed width. Values are checked to fit by `encode_elem_word`.
+static bool encode_packed_elem(uint8_t * out, ABI_t type, const void * val, size_t valSz) {
+  uint8_t word[ABI_WORD_SZ];
+  if (!encode_elem_word(word, type, val, valSz))
+    return false;
+  size_t w = packed_elem_sz(type);
+  memcpy(out, is_fixed_bytes_type(type) ? word : word + ABI_WORD_SZ - w, w);
+  return true;
+}
+
+// Set the intrinsic gas of calldata from its byte counts
+static void set_calldata_gas(ABICalldataStats_t * stats) {
+  stats->gas = (ABI_CALLDATA_ZERO_BYTE_GAS * (uint64_t) stats->zeroBytes) + 
+               (ABI_CALLDATA_NONZERO_BYTE_GAS * (uint64_t) stats->nonzeroBytes);
+}
+
+// Compare two big endian 32 byte words. Signed words are compared as two's complement.
+static int cmp_words(const uint8_t * a, const uint8_t * b, bool isSigned) {
+  if (isSigned && ((a[0] ^ b[0]) & 0x80))
+    return (a[0] & 0x80) ? -1 : 1;
+  return memcmp(a, b, ABI_WORD_SZ);
+}
+
+static bool predicate_matches(const ABIPredicate_t * pred, const uint8_t * in, size_t inSz) {
+  if (inSz < pred->minSz)
+    return false;
+  for (size_t i = 0; i < pred->numConditions; i++) {
+    const ABICompiledCondition_t * c = &pred->conditions[i];
+    int r = cmp_words(in + c->off, c->word, c->isSigned);
+    bool match = false;
+    switch (c->cmp) {
+      case ABI_CMP_EQ:
+        match = (r == 0);
+        break;
+      case ABI_CMP_NE:
+        match = (r != 0);
+        break;
+      case ABI_CMP_LT:
+        match = (r < 0);
+        break;
+      case ABI_CMP_LTE:
+        match = (r <= 0);
+        break;
+      case ABI_CMP_GT:
+        match = (r > 0);
+        break;
+      case ABI_CMP_GTE:
+        match = (r >= 0);
+        break;
+      default:
+        break;
+    }
+    if (!match)
+      return false;
+  }
+  return true;
+}
+
+// Keccak-256 (the original Keccak padding used by Ethereum, not SHA3-256)
+#define KECCAK_RATE 136
+
+static const uint64_t KECCAK_RC[24] = {
+  0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+  0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+  0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+  0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+  0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+  0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+static const int KECCAK_ROTC[24] = { 1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44 };
+static const int KECCAK_MOD5[10] = { 0, 1, 2, 3, 4, 0, 1, 2, 3, 4 };
+static const int KECCAK_PILN[24] = { 10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1 };
+
+static inline uint64_t rotl64(uint64_t x, int n) {
+  return (x << n) | (x >> (64 - n));
+}
+
+static void keccak_f1600(uint64_t * st) {
+  uint64_t bc[5];
+  for (int r = 0; r < 24; r++) {
+    // Theta
+    for (int i = 0; i < 5; i++)
+      bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+    for (int i = 0; i < 5; i++) {
+      uint64_t t = bc[KECCAK_MOD5[i + 4]] ^ rotl64(bc[KECCAK_MOD5[i + 1]], 1);
+      for (int j = 0; j < 25; j += 5)
+        st[j + i] ^= t;
+    }
+    // Rho and pi
+    uint64_t t = st[1];
+    for (int i = 0; i < 24; i++) {
+      int j = KECCAK_PILN[i];
+      bc[0] = st[j];
+      st[j] = rotl64(t, KECCAK_ROTC[i]);
+      t = bc[0];
+    }
+    // Chi
+    for (int j = 0; j < 25; j += 5) {
+      for (int i = 0; i < 5; i++)
+        bc[i] = st[j + i];
+      for (int i = 0; i < 5; i++)
+        st[j + i] ^= (~bc[KECCAK_MOD5[i + 1]]) & bc[KECCAK_MOD5[i + 2]];
+    }
+    // Iota
+    st[0] ^= KECCAK_RC[r];
+  }
+}
+
+// Absorb bytes into the state (lanes are little endian)
+static void keccak_absorb(uint64_t * st, const uint8_t * in, size_t inSz) {
+  for (size_t i = 0; i < inSz; i++)
+    st[i / 8] ^= (uint64_t) in[i] << (8 * (i % 8));
+}
+
+static void keccak256(uint8_t * out, const void * in, size_t inSz) {
+  uint64_t st[25] = { 0 };
+  const uint8_t * p = in;
+  for (; inSz >= KECCAK_RATE; inSz -= KECCAK_RATE, p += KECCAK_RATE) {
+    keccak_absorb(st, p, KECCAK_RATE);
+    keccak_f1600(st);
+  }
+  uint8_t block[KECCAK_RATE] = { 0 };
+  memcpy(block, p, inSz);
+  block[inSz] = 0x01;
+  block[KECCAK_RATE - 1] |= 0x80;
+  keccak_absorb(st, block, KECCAK_RATE);
+  keccak_f1600(st);
+  for (size_t i = 0; i < 32; i++)
+    out[i] = (uint8_t) (st[i / 8] >> (8 * (i % 8)));
+}
+
+// Apply the EIP-55 checksum to the 40 lowercase hex digits of an address: letters are
+// uppercased where the corresponding nibble of the digits' hash is at least 8.
+static void eip55_checksum(char * digits) {
+  uint8_t hash[32];
+  keccak256(hash, digits, 40);
+  for (size_t i = 0; i < 40; i++) {
+    uint8_t nibble = (i % 2 == 0) ? (hash[i / 2] >> 4) : (hash[i / 2] & 0xf);
+    if (digits[i] >= 'a' && nibble >= 8)
+      digits[i] -= ('a' - 'A');
+  }
+}
+
+// Append a string to a signature being built in `sig`, keeping it NUL terminated
+static bool sig_append(char * sig, size_t sigSz, size_t * pos, const char * str) {
+  size_t n = strlen(str);
+  if (n >= sigSz - *pos)
+    return false;
+  memcpy(sig + *pos, str, n + 1);
+  *pos += n;
+  return true;
+}
+
+static bool sig_append_uint(char * sig, size_t sigSz, size_t * pos, size_t n) {
+  char digits[24];
+  size_t i = sizeof(digits) - 1;
+  digits[i] = '\0';
+  do {
+    digits[--i] = (char) ('0' + (n % 10));
+    n /= 10;
+  } while (n > 0);
+  return sig_append(sig, sigSz, pos, digits + i);
+}
+
+// Append the canonical name of a param's type (e.g. `uint256`, `bytes32[2]`, `(address,bytes)[]`),
+// as used in function signatures.
+static bool sig_append_type(char * sig, size_t sigSz, size_t * pos, const ABI_t * types, size_t numTypes, size_t idx) {
+  ABI_t t = types[idx];
+  bool ok = true;
+  if (is_tuple_type(t)) {
+    int firstIdx = get_first_tuple_param_idx(types, numTypes, idx);
+    if (firstIdx < 0)
+      return false;
+    ok = sig_append(sig, sigSz, pos, "(");
+    for (size_t i = (size_t) firstIdx; ok && i < (size_t) firstIdx + get_tuple_sz(t); i++) {
+      // Params nested in tuples are appended after the root params, which do not include tuples
+      if (is_tuple_type(types[i]))
+        return false;
+      ok = (i == (size_t) firstIdx || sig_append(sig, sigSz, pos, ",")) &&
+           sig_append_type(sig, sigSz, pos, types, numTypes, i);
+    }
+    ok = ok && sig_append(sig, sigSz, pos, ")");
+  } else if (t.type >= ABI_UINT8 && t.type <= ABI_UINT256) {
+    ok = sig_append(sig, sigSz, pos, "uint") && sig_append_uint(sig, sigSz, pos, 8 * (1 + t.type - ABI_UINT8));
+  } else if (t.type >= ABI_INT8 && t.type <= ABI_INT256) {
+    ok = sig_append(sig, sigSz, pos, "int") && sig_append_uint(sig, sigSz, pos, 8 * (1 + t.type - ABI_INT8));
+  } else if (is_fixed_bytes_type(t)) {
+    ok = sig_append(sig, sigSz, pos, "bytes") && sig_append_uint(sig, sigSz, pos, 1 + t.type - ABI_BYTES1);
+  } else {
+    switch (t.type) {
+      case ABI_ADDRESS:
+        ok = sig_append(sig, sigSz, pos, "address");
+        break;
+      case ABI_BOOL:
+        ok = sig_append(sig, sigSz, pos, "bool");
+        break;
+      // Aliases are hashed by their full names
+      case ABI_UINT:
+        ok = sig_append(sig, sigSz, pos, "uint256");
+        break;
+      case ABI_INT:
+        ok = sig_append(sig, sigSz, pos, "int256");
+        break;
+      case ABI_BYTES:
+        ok = sig_append(sig, sigSz, pos, "bytes");
+        break;
+      case ABI_STRING:
+        ok = sig_append(sig, sigSz, pos, "string");
+        break;
+      default:
+        return false;
+    }
+  }
+  if (ok && t.isArray) {
+    ok = sig_append(sig, sigSz, pos, "[") &&
+         (t.arraySz == 0 || sig_append_uint(sig, sigSz, pos, t.arraySz)) &&
+         sig_append(sig, sigSz, pos, "]");
+  }
+  return ok;
+}
+
+//===============================================
+// KERNELS
+//===============================================
+// Sums of 256-bit words are accumulated as eight independent columns of 32-bit chunks
+// in 64-bit accumulators, which cannot overflow for up to 2^31 words. Carries between
+// chunks are only propagated when the accumulators are flushed.
+#define U256_SUM_FLUSH_INTERVAL (1UL << 31)
+
+static void u256_sum_scalar(uint64_t * acc, const uint8_t * words, size_t stride, size_t numWords) {
+  for (size_t i = 0; i < numWords; i++) {
+    const uint8_t * w = words + (i * stride);
+    for (size_t c = 0; c < 8; c++)
+      acc[c] += read_u32_be(w + (4 * c));
+  }
+}
+
+static int u256_cmp_scalar(const uint8_t * a, const uint8_t * b) {
+  return memcmp(a, b, ABI_WORD_SZ);
+}
+
+static const uint8_t * u256_select_scalar(const uint8_t * words, size_t stride, size_t numWords, int sign) {
+  const uint8_t * best = words;
+  for (size_t i = 1; i < numWords; i++) {
+    const uint8_t * w = words + (i * stride);
+    if (u256_cmp_scalar(w, best) * sign > 0)
+      best = w;
+  }
+  return best;
+}
+
+static size_t u256_count_gt_scalar(const uint8_t * words, size_t stride, size_t numWords, const uint8_t * threshold) {
+  size_t n = 0;
+  for (size_t i = 0; i < numWords; i++)
+    if (u256_cmp_scalar(words + (i * stride), threshold) > 0)
+      n++;
+  return n;
+}
+
+#ifdef ABI_X86_KERNELS
+__attribute__((target("avx2")))
+static void u256_sum_avx2(uint64_t * acc, const uint8_t * words, size_t stride, size_t numWords) {
+  // Byte swap each 32-bit chunk of a big endian word
+  const __m256i bswap32 = _mm256_setr_epi8( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  __m256i accHi = _mm256_loadu_si256((const __m256i *) acc);
+  __m256i accLo = _mm256_loadu_si256((const __m256i *) (acc + 4));
+  for (size_t i = 0; i < numWords; i++) {
+    __m256i w = _mm256_loadu_si256((const __m256i *) (words + (i * stride)));
+    w = _mm256_shuffle_epi8(w, bswap32);
+    accHi = _mm256_add_epi64(accHi, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(w)));
+    accLo = _mm256_add_epi64(accLo, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(w, 1)));
+  }
+  _mm256_storeu_si256((__m256i *) acc, accHi);
+  _mm256_storeu_si256((__m256i *) (acc + 4), accLo);
+}
+
+// Compare two big endian words. The first differing byte is found with a pair of
+// (unsigned) byte comparisons and decides the result.
+__attribute__((target("avx2")))
+static inline int u256_cmp_avx2(__m256i a, __m256i b) {
+  const __m256i bias = _mm256_set1_epi8((char) 0x80);
+  a = _mm256_xor_si256(a, bias);
+  b = _mm256_xor_si256(b, bias);
+  uint32_t gt = (uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(a, b));
+  uint32_t lt = (uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(b, a));
+  uint32_t diff = gt | lt;
+  if (diff == 0)
+    return 0;
+  return ((gt >> __builtin_ctz(diff)) & 1) ? 1 : -1;
+}
+
+__attribute__((target("avx2")))
+static const uint8_t * u256_select_avx2(const uint8_t * words, size_t stride, size_t numWords, int sign) {
+  const uint8_t * best = words;
+  __m256i bestW = _mm256_loadu_si256((const __m256i *) best);
+  for (size_t i = 1; i < numWords; i++) {
+    const uint8_t * w = words + (i * stride);
+    __m256i v = _mm256_loadu_si256((const __m256i *) w);
+    if (u256_cmp_avx2(v, bestW) * sign > 0) {
+      best = w;
+      bestW = v;
+    }
+  }
+  return best;
+}
+
+__attribute__((target("avx2")))
+static size_t u256_count_gt_avx2(const uint8_t * words, size_t stride, size_t numWords, const uint8_t * threshold) {
+  __m256i t = _mm256_loadu_si256((const __m256i *) threshold);
+  size_t n = 0;
+  for (size_t i = 0; i < numWords; i++) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) (words + (i * stride)));
+    n += (u256_cmp_avx2(v, t) > 0);
+  }
+  return n;
+}
+#endif
+
+// Addresses are the last 20 bytes of their words. When `checkPadding` is set, the
+// kernels return false if any of the 12 leading bytes of a word are not zero.
+#define ADDRESS_PADDING_SZ (ABI_WORD_SZ - 20)
+
+static bool pack_addresses_scalar(uint8_t * out, const uint8_t * words, size_t numWords, bool checkPadding) {
+  uint8_t padding = 0;
+  for (size_t i = 0; i < numWords; i++) {
+    const uint8_t * w = words + (i * ABI_WORD_SZ);
+    if (checkPadding)
+      for (size_t j = 0; j < ADDRESS_PADDING_SZ; j++)
+        padding |= w[j];
+    memcpy(out + (i * 20), w + ADDRESS_PADDING_SZ, 20);
+  }
+  return padding == 0;
+}
+
+#ifdef ABI_X86_KERNELS
+// Move the five dwords holding an address (dwords 3-7) to the front of the vector and
+// store the whole vector. The 12 trailing bytes of each store are overwritten by the
+// next address, so the last address is copied on its own to stay inside `out`.
+__attribute__((target("avx2")))
+static bool pack_addresses_avx2(uint8_t * out, const uint8_t * words, size_t numWords, bool checkPadding) {
+  const __m256i packIdx = _mm256_setr_epi32(3, 4, 5, 6, 7, 0, 0, 0);
+  const __m256i paddingMask = _mm256_setr_epi32(-1, -1, -1, 0, 0, 0, 0, 0);
+  __m256i padding = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 1 < numWords; i++) {
+    __m256i w = _mm256_loadu_si256((const __m256i *) (words + (i * ABI_WORD_SZ)));
+    padding = _mm256_or_si256(padding, w);
+    _mm256_storeu_si256((__m256i *) (out + (i * 20)), _mm256_permutevar8x32_epi32(w, packIdx));
+  }
+  bool ok = !checkPadding || _mm256_testz_si256(padding, paddingMask);
+  if (i < numWords)
+    ok &= pack_addresses_scalar(out + (i * 20), words + (i * ABI_WORD_SZ), 1, checkPadding);
+  return ok;
+}
+#endif
+
+// Padding checks accumulate the difference between the padding bits of each word and
+// their expected value, so a whole array is checked with a single branch at the end.
+static bool check_padding_scalar(const uint8_t * words, size_t numWords, const ABIPadding_t * pad) {
+  uint8_t diff = 0;
+  for (size_t i = 0; i < numWords; i++) {
+    const uint8_t * w = words + (i * ABI_WORD_SZ);
+    uint8_t fill = (pad->isSigned && (w[pad->signIdx] & 0x80)) ? 0xff : 0;
+    for (size_t j = 0; j < ABI_WORD_SZ; j++)
+      diff |= (w[j] ^ fill) & pad->mask[j];
+  }
+  return diff == 0;
+}
+
+#ifdef ABI_X86_KERNELS
+__attribute__((target("avx2")))
+static bool check_padding_avx2(const uint8_t * words, size_t numWords, const ABIPadding_t * pad) {
+  __m256i mask = _mm256_loadu_si256((const __m256i *) pad->mask);
+  __m256i diff = _mm256_setzero_si256();
+  for (size_t i = 0; i < numWords; i++) {
+    const uint8_t * w = words + (i * ABI_WORD_SZ);
+    __m256i v = _mm256_loadu_si256((const __m256i *) w);
+    if (pad->isSigned)
+      v = _mm256_xor_si256(v, _mm256_set1_epi8((char) ((int8_t) w[pad->signIdx] >> 7)));
+    diff = _mm256_or_si256(diff, v);
+  }
+  return _mm256_testz_si256(diff, mask);
+}
+#endif
+
+// Reverse the bytes of each word and keep the first `sz` bytes, i.e. convert big endian numbers
+// stored at the end of their words into packed little endian numbers of `sz` bytes.
+static void swap_words_scalar(uint8_t * out, const uint8_t * words, size_t numWords, size_t sz) {
+  for (size_t i = 0; i < numWords; i++) {
+    const uint8_t * w = words + (i * ABI_WORD_SZ);
+    for (size_t j = 0; j < sz; j++)
+      out[(i * sz) + j] = w[ABI_WORD_SZ - 1 - j];
+  }
+}
+
+#ifdef ABI_X86_KERNELS
+// Each word is reversed by reversing the bytes in each 128-bit lane and swapping the lanes,
+// then stored whole. Stores overlap like in `pack_addresses_avx2`, so we stop once there
+// is less than a word of room left in `out` and swap the remaining words on their own.
+__attribute__((target("avx2")))
+static void swap_words_avx2(uint8_t * out, const uint8_t * words, size_t numWords, size_t sz) {
+  const __m256i rev = _mm256_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  size_t numTail = (ABI_WORD_SZ + sz - 1) / sz;
+  size_t i = 0;
+  for (; i + numTail <= numWords; i++) {
+    __m256i w = _mm256_loadu_si256((const __m256i *) (words + (i * ABI_WORD_SZ)));
+    w = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(w, rev), 0x4e);
+    _mm256_storeu_si256((__m256i *) (out + (i * sz)), w);
+  }
+  swap_words_scalar(out + (i * sz), words + (i * ABI_WORD_SZ), numWords - i, sz);
+}
+#endif
+
+// Pack bools into a bitset (bit `i % 8` of `out[i / 8]` is bool `i`). Returns false if any
+// word is not 0 or 1. `out` must be zeroed by the caller.
+static bool pack_bools_scalar(uint8_t * out, const uint8_t * words, size_t numWords) {
+  uint8_t invalid = 0;
+  for (size_t i = 0; i < numWords; i++) {
+    const uint8_t * w = words + (i * ABI_WORD_SZ);
+    for (size_t j = 0; j < ABI_WORD_SZ - 1; j++)
+      invalid |= w[j];
+    invalid |= w[ABI_WORD_SZ - 1] & 0xfe;
+    out[i / 8] |= (w[ABI_WORD_SZ - 1] & 1) << (i % 8);
+  }
+  return invalid == 0;
+}
+
+#ifdef ABI_X86_KERNELS
+// Shifting each 64-bit lane left by 7 moves the low bit of the last byte of the word into
+// its top bit, which is the top bit of the movemask. Eight words make up a byte of output.
+__attribute__((target("avx2")))
+static bool pack_bools_avx2(uint8_t * out, const uint8_t * words, size_t numWords) {
+  const __m256i validMask = _mm256_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                              -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char) 0xfe);
+  __m256i invalid = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= numWords; i += 8) {
+    uint32_t bits = 0;
+    for (size_t j = 0; j < 8; j++) {
+      __m256i w = _mm256_loadu_si256((const __m256i *) (words + ((i + j) * ABI_WORD_SZ)));
+      invalid = _mm256_or_si256(invalid, w);
+      bits |= ((uint32_t) _mm256_movemask_epi8(_mm256_slli_epi64(w, 7)) >> 31) << j;
+    }
+    out[i / 8] = (uint8_t) bits;
+  }
+  bool ok = _mm256_testz_si256(invalid, validMask);
+  return pack_bools_scalar(out + (i / 8), words + (i * ABI_WORD_SZ), numWords - i) && ok;
+}
+#endif
+
+// Narrow big endian unsigned words into packed native integers of `width` bytes. Returns false
+// if any word does not fit, i.e. has a nonzero byte among the `32 - width` bytes discarded.
+static bool narrow_words_scalar(uint8_t * out, const uint8_t * words, size_t numWords, size_t width) {
+  uint8_t overflow = 0;
+  for (size_t i = 0; i < numWords; i++) {
+    const uint8_t * w = words + (i * ABI_WORD_SZ);
+    for (size_t j = 0; j < ABI_WORD_SZ - width; j++)
+      overflow |= w[j];
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    memcpy(out + (i * width), w + ABI_WORD_SZ - width, width);
+#else
+    for (size_t j = 0; j < width; j++)
+      out[(i * width) + j] = w[ABI_WORD_SZ - 1 - j];
+#endif
+  }
+  return overflow == 0;
+}
+
+#ifdef ABI_X86_KERNELS
+// Swap words as in `swap_words_avx2` while accumulating the discarded bytes, which are
+// checked once at the end.
+__attribute__((target("avx2")))
+static bool narrow_words_avx2(uint8_t * out, const uint8_t * words, size_t numWords, size_t width) {
+  const __m256i rev = _mm256_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  // The discarded bytes are the ones below index `32 - width`
+  const __m256i idx = _mm256_setr_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+  const __m256i mask = _mm256_cmpgt_epi8(_mm256_set1_epi8((char) (ABI_WORD_SZ - width)), idx);
+  __m256i overflow = _mm256_setzero_si256();
+  size_t numTail = (ABI_WORD_SZ + width - 1) / width;
+  size_t i = 0;
+  for (; i + numTail <= numWords; i++) {
+    __m256i w = _mm256_loadu_si256((const __m256i *) (words + (i * ABI_WORD_SZ)));
+    overflow = _mm256_or_si256(overflow, w);
+    w = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(w, rev), 0x4e);
+    _mm256_storeu_si256((__m256i *) (out + (i * width)), w);
+  }
+  bool ok = _mm256_testz_si256(overflow, mask);
+  return narrow_words_scalar(out + (i * width), words + (i * ABI_WORD_SZ), numWords - i, width) && ok;
+}
+#endif
+
+// Get the value of a hex digit (either case); -1 if it is not one.
+static inline int hex_nibble(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f')
+    return 10 + (c - 'a');
+  return -1;
+}
+
+// Convert `2 * numBytes` hex digits into bytes. Returns false if there is a non-hex character.
+static bool hex_decode_scalar(uint8_t * out, const char * hex, size_t numBytes) {
+  for (size_t i = 0; i < numBytes; i++) {
+    int hi = hex_nibble(hex[2 * i]);
+    int lo = hex_nibble(hex[(2 * i) + 1]);
+    if (hi < 0 || lo < 0)
+      return false;
+    out[i] = (uint8_t) ((hi << 4) | lo);
+  }
+  return true;
+}
+
+#ifdef ABI_X86_KERNELS
+// Digits and letters are classified by range checks on `c - '0'` and `(c | 0x20) - 'a'`
+// (using unsigned min, which has no compare). Each pair of nibbles is then combined into
+// a byte with a multiply-add and the 16-bit results are packed back down to bytes.
+__attribute__((target("ssse3")))
+static inline __m128i hex_nibbles_ssse3(__m128i v, __m128i * invalid) {
+  __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+  __m128i l = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+  __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+  *invalid = _mm_or_si128(*invalid, _mm_xor_si128(_mm_or_si128(isDigit, isLetter), _mm_set1_epi8(-1)));
+  return _mm_or_si128(_mm_and_si128(isDigit, d), 
+                      _mm_and_si128(isLetter, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+__attribute__((target("ssse3")))
+static bool hex_decode_ssse3(uint8_t * out, const char * hex, size_t numBytes) {
+  const __m128i pairs = _mm_set1_epi16(0x0110);
+  __m128i invalid = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= numBytes; i += 16) {
+    __m128i a = hex_nibbles_ssse3(_mm_loadu_si128((const __m128i *) (hex + (2 * i))), &invalid);
+    __m128i b = hex_nibbles_ssse3(_mm_loadu_si128((const __m128i *) (hex + (2 * i) + 16)), &invalid);
+    a = _mm_maddubs_epi16(a, pairs);
+    b = _mm_maddubs_epi16(b, pairs);
+    _mm_storeu_si128((__m128i *) (out + i), _mm_packus_epi16(a, b));
+  }
+  if (_mm_movemask_epi8(invalid) != 0)
+    return false;
+  return hex_decode_scalar(out + i, hex + (2 * i), numBytes - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i hex_nibbles_avx2(__m256i v, __m256i * invalid) {
+  __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+  __m256i l = _mm256_sub_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+  __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+  __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(l, _mm256_set1_epi8(5)), l);
+  *invalid = _mm256_or_si256(*invalid, _mm256_xor_si256(_mm256_or_si256(isDigit, isLetter), _mm256_set1_epi8(-1)));
+  return _mm256_or_si256( _mm256_and_si256(isDigit, d), 
+                          _mm256_and_si256(isLetter, _mm256_add_epi8(l, _mm256_set1_epi8(10))));
+}
+
+// As `hex_decode_ssse3`, except packing works within 128-bit lanes, so the
+// 64-bit quarters of the result need to be put back in order.
+__attribute__((target("avx2")))
+static bool hex_decode_avx2(uint8_t * out, const char * hex, size_t numBytes) {
+  const __m256i pairs = _mm256_set1_epi16(0x0110);
+  __m256i invalid = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= numBytes; i += 32) {
+    __m256i a = hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *) (hex + (2 * i))), &invalid);
+    __m256i b = hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *) (hex + (2 * i) + 32)), &invalid);
+    a = _mm256_maddubs_epi16(a, pairs);
+    b = _mm256_maddubs_epi16(b, pairs);
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+    _mm256_storeu_si256((__m256i *) (out + i), packed);
+  }
+  if (!_mm256_testz_si256(invalid, invalid))
+    return false;
+  return hex_decode_scalar(out + i, hex + (2 * i), numBytes - i);
+}
+#endif
+
+// Write `2 * inSz` lowercase hex digits.
+static void hex_encode_scalar(char * out, const uint8_t * in, size_t inSz) {
+  static const char digits[] = "0123456789abcdef";
+  for (size_t i = 0; i < inSz; i++) {
+    out[2 * i] = digits[in[i] >> 4];
+    out[(2 * i) + 1] = digits[in[i] & 0xf];
+  }
+}
+
+#ifdef ABI_X86_KERNELS
+// Nibbles are split out of each byte, looked up in a table of digits with a shuffle,
+// and interleaved back into digit pairs.
+__attribute__((target("ssse3")))
+static void hex_encode_ssse3(char * out, const uint8_t * in, size_t inSz) {
+  const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m128i lowNibbles = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= inSz; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+    __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), lowNibbles));
+    __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, lowNibbles));
+    _mm_storeu_si128((__m128i *) (out + (2 * i)), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *) (out + (2 * i) + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+  hex_encode_scalar(out + (2 * i), in + i, inSz - i);
+}
+
+// As `hex_encode_ssse3`, except interleaving works within 128-bit lanes, so the
+// lanes of the two interleaved vectors are recombined in order.
+__attribute__((target("avx2")))
+static void hex_encode_avx2(char * out, const uint8_t * in, size_t inSz) {
+  const __m256i digits = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                                          '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 32 <= inSz; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) (in + i));
+    __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibbles));
+    __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, lowNibbles));
+    __m256i a = _mm256_unpacklo_epi8(hi, lo);
+    __m256i b = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256((__m256i *) (out + (2 * i)), _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256((__m256i *) (out + (2 * i) + 32), _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  hex_encode_scalar(out + (2 * i), in + i, inSz - i);
+}
+#endif
+
+// Match the selector (first 4 bytes) of each payload against `numSelectors` targets, writing
+// the index of the first matching target (or -1) to `matches`. Selectors are compared as
+// 32-bit words in memory order. Returns the number of payloads matched.
+static size_t match_selectors_scalar( int * matches, 
+                                      const void * const * ins, 
+                                      const size_t * inSzs, 
+                                      size_t numIns, 
+                                      const uint32_t * selectors, 
+                                      size_t numSelectors)
+{
+  size_t numMatched = 0;
+  for (size_t i = 0; i < numIns; i++) {
+    matches[i] = -1;
+    if (!ins[i] || inSzs[i] < ABI_SELECTOR_SZ)
+      continue;
+    uint32_t sel;
+    memcpy(&sel, ins[i], ABI_SELECTOR_SZ);
+    for (size_t j = 0; j < numSelectors; j++) {
+      if (sel == selectors[j]) {
+        matches[i] = j;
+        numMatched++;
+        break;
+      }
+    }
+  }
+  return numMatched;
+}
+
+#ifdef ABI_X86_KERNELS
+// The targets are held in two registers of 8 selectors each. Each payload's selector is
+// broadcast and compared against all 16 at once; the lowest set bit of the combined mask
+// is the first match.
+__attribute__((target("avx2")))
+static size_t match_selectors_avx2( int * matches, 
+                                    const void * const * ins, 
+                                    const size_t * inSzs, 
+                                    size_t numIns, 
+                                    const uint32_t * selectors, 
+                                    size_t numSelectors)
+{
+  uint32_t padded[ABI_MATCH_SELECTORS_MAX] = { 0 };
+  memcpy(padded, selectors, numSelectors * sizeof(uint32_t));
+  const __m256i lo = _mm256_loadu_si256((const __m256i *) padded);
+  const __m256i hi = _mm256_loadu_si256((const __m256i *) (padded + 8));
+  const uint32_t validMask = (1u << numSelectors) - 1;
+  size_t numMatched = 0;
+  for (size_t i = 0; i < numIns; i++) {
+    matches[i] = -1;
+    if (!ins[i] || inSzs[i] < ABI_SELECTOR_SZ)
+      continue;
+    uint32_t sel;
+    memcpy(&sel, ins[i], ABI_SELECTOR_SZ);
+    __m256i v = _mm256_set1_epi32((int) sel);
+    uint32_t mask = (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, lo))) |
+                    ((uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, hi))) << 8);
+    mask &= validMask;
+    if (mask) {
+      matches[i] = __builtin_ctz(mask);
+      numMatched++;
+    }
+  }
+  return numMatched;
+}
+#endif
+
+// Count the zero bytes, all-zero words and runs of consecutive all-zero words in a payload.
+// Words are aligned to the start of the payload; a partial word at the end only counts bytes.
+static void calldata_stats_scalar(ABICalldataStats_t * stats, const uint8_t * in, size_t inSz) {
+  bool prevZero = false;
+  for (size_t i = 0; i < inSz; i += ABI_WORD_SZ) {
+    size_t n = (inSz - i) < ABI_WORD_SZ ? (inSz - i) : ABI_WORD_SZ;
+    size_t wordZeros = 0;
+    for (size_t j = 0; j < n; j++)
+      wordZeros += (in[i + j] == 0);
+    stats->zeroBytes += wordZeros;
+    bool isZero = (wordZeros == ABI_WORD_SZ);
+    if (isZero) {
+      stats->zeroWords++;
+      if (!prevZero)
+        stats->zeroWordRuns++;
+    }
+    prevZero = isZero;
+  }
+}
+
+#ifdef ABI_X86_KERNELS
+// Each word is compared against zero into a 32-bit mask, which gives its zero byte count
+// and whether it is all zero. Runs are counted 4 words at a time from a bitmask of zero
+// words: a run starts at every zero word whose predecessor is not zero.
+__attribute__((target("avx2")))
+static void calldata_stats_avx2(ABICalldataStats_t * stats, const uint8_t * in, size_t inSz) {
+  const __m256i zero = _mm256_setzero_si256();
+  uint32_t prevZero = 0;
+  size_t i = 0;
+  while (i + ABI_WORD_SZ <= inSz) {
+    size_t numWords = (inSz - i) / ABI_WORD_SZ;
+    if (numWords > 4)
+      numWords = 4;
+    uint32_t z = 0;
+    for (size_t w = 0; w < numWords; w++) {
+      __m256i v = _mm256_loadu_si256((const __m256i *) (in + i + (w * ABI_WORD_SZ)));
+      uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero));
+      stats->zeroBytes += __builtin_popcount(mask);
+      z |= (uint32_t) (mask == 0xffffffff) << w;
+    }
+    stats->zeroWords += __builtin_popcount(z);
+    stats->zeroWordRuns += __builtin_popcount(z & ~((z << 1) | prevZero));
+    prevZero = (z >> (numWords - 1)) & 1;
+    i += numWords * ABI_WORD_SZ;
+  }
+  for (; i < inSz; i++)
+    stats->zeroBytes += (in[i] == 0);
+}
+#endif
+
+// Every vectorized kernel is called through a table of implementations for the level of
+// CPU support we are running on. Levels without a vectorized version of a kernel use the
+// best version below them. AVX-512 machines use the AVX2 table.
+typedef struct {
+  bool (*pack_addresses)(uint8_t * out, const uint8_t * words, size_t numWords, bool checkPadding);
+  bool (*check_padding)(const uint8_t * words, size_t numWords, const ABIPadding_t * pad);
+  void (*swap_words)(uint8_t * out, const uint8_t * words, size_t numWords, size_t sz);
+  bool (*pack_bools)(uint8_t * out, const uint8_t * words, size_t numWords);
+  bool (*narrow_words)(uint8_t * out, const uint8_t * words, size_t numWords, size_t width);
+  bool (*hex_decode)(uint8_t * out, const char * hex, size_t numBytes);
+  void (*hex_encode)(char * out, const uint8_t * in, size_t inSz);
+  size_t (*match_selectors)(int * matches, const void * const * ins, const size_t * inSzs, size_t numIns, 
+                            const uint32_t * selectors, size_t numSelectors);
+  void (*u256_sum)(uint64_t * acc, const uint8_t * words, size_t stride, size_t numWords);
+  const uint8_t * (*u256_select)(const uint8_t * words, size_t stride, size_t numWords, int sign);
+  size_t (*u256_count_gt)(const uint8_t * words, size_t stride, size_t numWords, const uint8_t * threshold);
+  void (*calldata_stats)(ABICalldataStats_t * stats, const uint8_t * in, size_t inSz);
+} ABIKernels_t;
+
+static const ABIKernels_t KERNELS_SCALAR = {
+  .pack_addresses = pack_addresses_scalar,
+  .check_padding = check_padding_scalar,
+  .swap_words = swap_words_scalar,
+  .pack_bools = pack_bools_scalar,
+  .narrow_words = narrow_words_scalar,
+  .hex_decode = hex_decode_scalar,
+  .hex_encode = hex_encode_scalar,
+  .match_selectors = match_selectors_scalar,
+  .u256_sum = u256_sum_scalar,
+  .u256_select = u256_select_scalar,
+  .u256_count_gt = u256_count_gt_scalar,
+  .calldata_stats = calldata_stats_scalar,
+};
+
+#ifdef ABI_X86_KERNELS
+static const ABIKernels_t KERNELS_SSSE3 = {
+  .pack_addresses = pack_addresses_scalar,
+  .check_padding = check_padding_scalar,
+  .swap_words = swap_words_scalar,
+  .pack_bools = pack_bools_scalar,
+  .narrow_words = narrow_words_scalar,
+  .hex_decode = hex_decode_ssse3,
+  .hex_encode = hex_encode_ssse3,
+  .match_selectors = match_selectors_scalar,
+  .u256_sum = u256_sum_scalar,
+  .u256_select = u256_select_scalar,
+  .u256_count_gt = u256_count_gt_scalar,
+  .calldata_stats = calldata_stats_scalar,
+};
+
+static const ABIKernels_t KERNELS_AVX2 = {
+  .pack_addresses = pack_addresses_avx2,
+  .check_padding = check_padding_avx2,
+  .swap_words = swap_words_avx2,
+  .pack_bools = pack_bools_avx2,
+  .narrow_words = narrow_words_avx2,
+  .hex_decode = hex_decode_avx2,
+  .hex_encode = hex_encode_avx2,
+  .match_selectors = match_selectors_avx2,
+  .u256_sum = u256_sum_avx2,
+  .u256_select = u256_select_avx2,
+  .u256_count_gt = u256_count_gt_avx2,
+  .calldata_stats = calldata_stats_avx2,
+};
+#endif
+
+// The selected variant is shared by all threads. It only ever changes between whole
+// tables, so relaxed atomic access is enough.
+#if defined(__GNUC__)
+#define KERNELS_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define KERNELS_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#else
+#define KERNELS_LOAD(p) (*(p))
+#define KERNELS_STORE(p, v) (*(p) = (v))
+#endif
+
+static int activeKernels = ABI_KERNELS_AUTO;
+
+static const ABIKernels_t * get_kernel_table(int variant) {
+  switch (variant) {
+#ifdef ABI_X86_KERNELS
+    case ABI_KERNELS_SSSE3:
+      return &KERNELS_SSSE3;
+    case ABI_KERNELS_AVX2:
+      return &KERNELS_AVX2;
+#endif
+    default:
+      return &KERNELS_SCALAR;
+  }
+}
+
+static bool kernels_supported(int variant) {
+  switch (variant) {
+    case ABI_KERNELS_SCALAR:
+      return true;
+#ifdef ABI_X86_KERNELS
+    case ABI_KERNELS_SSSE3:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("ssse3");
+    case ABI_KERNELS_AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+// Pick the best supported variant, unless `ABI_FORCE_SCALAR` is set (to anything but "0")
+static int detect_kernels(void) {
+  const char * forceScalar = getenv("ABI_FORCE_SCALAR");
+  if (forceScalar && forceScalar[0] != '\0' && strcmp(forceScalar, "0") != 0)
+    return ABI_KERNELS_SCALAR;
+  if (kernels_supported(ABI_KERNELS_AVX2))
+    return ABI_KERNELS_AVX2;
+  if (kernels_supported(ABI_KERNELS_SSSE3))
+    return ABI_KERNELS_SSSE3;
+  return ABI_KERNELS_SCALAR;
+}
+
+static int get_kernel_variant(void) {
+  int variant = KERNELS_LOAD(&activeKernels);
+  if (variant == ABI_KERNELS_AUTO) {
+    variant = detect_kernels();
+    KERNELS_STORE(&activeKernels, variant);
+  }
+  return variant;
+}
+
+static const ABIKernels_t * get_kernels(void) {
+  return get_kernel_table(get_kernel_variant());
+}
+
+static bool pack_addresses(uint8_t * out, const uint8_t * words, size_t numWords, bool checkPadding) {
+  return get_kernels()->pack_addresses(out, words, numWords, checkPadding);
+}
+
+static bool check_padding(const uint8_t * words, size_t numWords, const ABIPadding_t * pad) {
+  return get_kernels()->check_padding(words, numWords, pad);
+}
+
+static void swap_words(uint8_t * out, const uint8_t * words, size_t numWords, size_t sz) {
+  get_kernels()->swap_words(out, words, numWords, sz);
+}
+
+static bool pack_bools(uint8_t * out, const uint8_t * words, size_t numWords) {
+  return get_kernels()->pack_bools(out, words, numWords);
+}
+
+static bool narrow_words(uint8_t * out, const uint8_t * words, size_t numWords, size_t width) {
+  return get_kernels()->narrow_words(out, words, numWords, width);
+}
+
+static bool hex_decode(uint8_t * out, const char * hex, size_t numBytes) {
+  return get_kernels()->hex_decode(out, hex, numBytes);
+}
+
+static void hex_encode(char * out, const uint8_t * in, size_t inSz) {
+  get_kernels()->hex_encode(out, in, inSz);
+}
+
+static size_t match_selectors(int * matches, 
+                              const void * const * ins, 
+                              const size_t * inSzs, 
+                              size_t numIns, 
+                              const uint32_t * selectors, 
+                              size_t numSelectors)
+{
+  return get_kernels()->match_selectors(matches, ins, inSzs, numIns, selectors, numSelectors);
+}
+
+static void u256_sum(uint64_t * acc, const uint8_t * words, size_t stride, size_t numWords) {
+  get_kernels()->u256_sum(acc, words, stride, numWords);
+}
+
+static const uint8_t * u256_select(const uint8_t * words, size_t stride, size_t numWords, int sign) {
+  return get_kernels()->u256_select(words, stride, numWords, sign);
+}
+
+static size_t u256_count_gt(const uint8_t * words, size_t stride, size_t numWords, const uint8_t * threshold) {
+  return get_kernels()->u256_count_gt(words, stride, numWords, threshold);
+}
+
+static void calldata_stats(ABICalldataStats_t * stats, const uint8_t * in, size_t inSz) {
+  get_kernels()->calldata_stats(stats, in, inSz);
+}
+
+// Add a set of chunk accumulators into a running sum, which is stored as eight
+// 32-bit chunks (most significant first). Returns false on 256-bit overflow.
+static bool u256_sum_flush(uint32_t * sum, const uint64_t * acc) {
+  uint64_t carry = 0;
+  for (int c = 7; c >= 0; c--) {
+    uint64_t v = acc[c] + sum[c] + carry;
+    sum[c] = (uint32_t) v;
+    carry = v >> 32;
+  }
+  return carry == 0;
+}
+
+//===============================================
+// API
+//===============================================
+bool is_tuple_type(ABI_t t) {
+  return (t.type <= ABI_TUPLE20 && t.type >= ABI_TUPLE1);
+}
+
+int get_tuple_sz(ABI_t t) {
+  if (!is_tuple_type(t))
+    return -1;
+  return (t.type - ABI_TUPLE1) + 1; 
+}
+
+bool abi_is_valid_schema(const ABI_t * types, size_t numTypes) {
+  if (!types)
+    return false;
+  for (size_t i = 0; i < numTypes; i++) {
+    if ((types[i].type >= ABI_MAX || types[i].type <= ABI_NONE) ||
+        ( (!is_single_elementary_type(types[i])) &&
+          (!is_single_dynamic_type(types[i])) &&
+          (!is_tuple_type(types[i])) &&
+          (!is_elementary_type_fixed_sz_array(types[i])) &&
+          (!is_elementary_type_variable_sz_array(types[i])) &&
+          (!is_dynamic_type_fixed_sz_array(types[i])) &&
+          (!is_dynamic_type_variable_sz_array(types[i])) ))
+      return false;
+  }
+  return true;
+}
+
+int abi_get_array_sz( const ABI_t * types, 
+                      size_t numTypes, 
+                      ABISelector_t info, 
+                      const void * in,
+                      size_t inSz)
+{
+  if (!types || !in)
+    return -1;
+  ABI_t type = types[info.typeIdx];
+  if (info.typeIdx >= numTypes || !abi_is_valid_schema(types, numTypes))
+    return -1;
+  // Fixed size arrays have size included
+  if (!is_variable_sz_array(type))
+    return type.arraySz;
+  // Get the offset of this parameter in the function definition
+  size_t paramOff = get_param_offset(types, numTypes, info, in, inSz);
+  if (paramOff > inSz)
+    return -1;
+  // The parameter at `paramOff` contains an offset where the array
+  // data begins. Since the first word in a variable sized array
+  // (which this must be) contains the array size, that's what we need.
+  return get_abi_u32_be(in, paramOff);
+}
+
+int abi_get_tuple_param_array_sz( const ABI_t * types, 
+                                  size_t numTypes, 
+                                  ABISelector_t tupleInfo,
+                                  ABISelector_t paramInfo, 
+                                  const void * in,
+                                  size_t inSz)
+{
+  if (!types || !in)
+    return -1;
+  int firstIdx = get_first_tuple_param_idx(types, numTypes, tupleInfo.typeIdx);
+  if (firstIdx < 0)
+    return -1;
+  size_t typeIdx = (size_t) firstIdx + paramInfo.typeIdx;
+  if (typeIdx >= numTypes || !abi_is_valid_schema(types, numTypes))
+    return -1;
+  ABI_t type = types[typeIdx];
+  // Fixed size arrays have size included
+  if (!is_variable_sz_array(type))
+    return type.arraySz;
+  // Update types pointer offset to skip non-tuple types. This allows us to treat
+  // the tuple as its own sort of "nested" definition.
+  int firstTupleParamIdx = get_first_tuple_param_idx(types, numTypes, tupleInfo.typeIdx);
+  if (firstTupleParamIdx < 0)
+    return -1;
+  const ABI_t * tupleTypes = types + firstTupleParamIdx;
+  // Get the offset at which the tuple data starts
+  size_t dataOff = get_tuple_data_start(types, numTypes, tupleInfo, in, inSz);
+  // Jump to the start of our tuple item
+  in += dataOff;
+  inSz -= dataOff;
+  size_t paramOff = get_param_offset(tupleTypes, (numTypes - firstTupleParamIdx), paramInfo, in, inSz);
+  return get_abi_u32_be(in, paramOff);
+}
+
+int abi_decode_param( void * out, 
+                      size_t outSz, 
+                      const ABI_t * types, 
+                      size_t numTypes, 
+                      ABISelector_t info, 
+                      const void * in,
+                      size_t inSz) 
+{
+  if (!out || !types || !in)
+    return -1;
+  // Ensure we have valid types passed
+  if ((info.typeIdx >= numTypes) ||
+      (!abi_is_valid_schema(types, numTypes)))
+    return -1;
+  size_t paramOff = get_param_offset(types, numTypes, info, in, inSz);
+  if (paramOff > inSz)
+    return -1;
+  return decode_param(out, outSz, types[info.typeIdx], in, inSz, paramOff, info);
+}
+
+int abi_decode_tuple_param( void * out, 
+                            size_t outSz, 
+                            const ABI_t * types, 
+                            size_t numTypes,
+                            ABISelector_t tupleInfo,
+                            ABISelector_t paramInfo, 
+                            const void * in,
+                            size_t inSz) 
+{
+  if (!out || !types || !in)
+    return -1;
+  // Ensure we have valid types passed
+  if (tupleInfo.typeIdx >= numTypes || !abi_is_valid_schema(types, numTypes))
+    return -1;
+  ABI_t tupleType = types[tupleInfo.typeIdx];
+  size_t tupleTypeSz = get_tuple_sz(tupleType);
+  // Sanity check: ensure this is a tuple type
+  if (!is_tuple_type(tupleType))
+    return -1;
+  // Sanity check: ensure we won't overrun our buffer
+  if (paramInfo.typeIdx > tupleTypeSz || paramInfo.typeIdx > numTypes)
+    return -1;
+  // Update types pointer offset to skip non-tuple types. This allows us to treat
+  // the tuple as its own sort of "nested" definition.
+  int paramIdx = get_first_tuple_param_idx(types, numTypes, tupleInfo.typeIdx);
+  if (paramIdx < 0)
+    return -1;
+  const ABI_t * tupleTypes = types + paramIdx;
+
+  // Get the offset at which the tuple data starts
+  size_t dataOff = get_tuple_data_start(types, numTypes, tupleInfo, in, inSz);
+  if (dataOff > inSz)
+    return -1;
+  // Jump to the start of our tuple item
+  in += dataOff;
+  inSz -= dataOff;
+  return abi_decode_param(out, 
+                          outSz, 
+                          tupleTypes, 
+                          tupleTypeSz,
+                          paramInfo,
+                          in,
+                          inSz);
+}
+
+int abi_decode_walk(void * out,
+                    size_t outSz,
+                    ABIItem_t * items,
+                    size_t numItems,
+                    const ABI_t * types,
+                    size_t numTypes,
+                    const bool * projection,
+                    const void * in,
+                    size_t inSz,
+                    uint32_t flags)
+{
+  if (!out || !items || !types || !in)
+    return -1;
+  if (!abi_is_valid_schema(types, numTypes))
+    return -1;
+  ABIWalkCtx_t ctx = {
+    .out = out, .outSz = outSz, .items = items, .numItems = numItems, .flags = flags,
+  };
+  if (!walk_payload(&ctx, types, numTypes, projection, in, inSz, 0))
+    return -1;
+  return ctx.itemOff;
+}
+
+int abi_decode_batch( void * out,
+                      size_t outSz,
+                      ABIItem_t * items,
+                      size_t numItems,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      const bool * projection,
+                      const void * const * ins,
+                      const size_t * inSzs,
+                      size_t numIns,
+                      int * counts,
+                      uint32_t flags)
+{
+  if (!out || !items || !types || !ins || !inSzs)
+    return -1;
+  // The schema is shared by every payload, so we only need to validate it once
+  if (!abi_is_valid_schema(types, numTypes))
+    return -1;
+  ABIWalkCtx_t ctx = {
+    .out = out, .outSz = outSz, .items = items, .numItems = numItems, .flags = flags,
+  };
+  for (size_t i = 0; i < numIns; i++)
+    decode_batch_payload(&ctx, types, numTypes, projection, ins[i], inSzs[i], i, counts);
+  return ctx.itemOff;
+}
+
+int abi_decode_array( void * out,
+                      size_t outSz,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      ABISelector_t info,
+                      const void * in,
+                      size_t inSz,
+                      uint32_t flags)
+{
+  if (!out || !types || !in)
+    return -1;
+  if ((info.typeIdx >= numTypes) ||
+      (info.typeIdx >= get_num_root_types(types, numTypes)) ||
+      (!abi_is_valid_schema(types, numTypes)))
+    return -1;
+  ABI_t type = types[info.typeIdx];
+  size_t wordsOff = 0;
+  int numElems = locate_elem_array(types, numTypes, info.typeIdx, in, inSz, &wordsOff);
+  if (numElems < 0)
+    return -1;
+  const uint8_t * words = (const uint8_t *) in + wordsOff;
+  if ((type.type == ABI_BOOL) && (flags & ABI_DECODE_BITSET)) {
+    size_t bitsetSz = (numElems + 7) / 8;
+    if (bitsetSz > outSz)
+      return -1;
+    memset(out, 0, bitsetSz);
+    if (!pack_bools(out, words, numElems))
+      return -1;
+    return numElems;
+  }
+  size_t sz = elem_sz(type);
+  if ((size_t) numElems > outSz / sz)
+    return -1;
+  if (type.type == ABI_ADDRESS) {
+    if (!pack_addresses(out, words, numElems, flags & ABI_DECODE_STRICT))
+      return -1;
+    return numElems;
+  }
+  if (flags & ABI_DECODE_STRICT) {
+    ABIPadding_t pad;
+    get_elem_padding(type, &pad);
+    if (!check_padding(words, numElems, &pad))
+      return -1;
+  }
+  if (is_swapped(type, flags)) {
+    swap_words(out, words, numElems, sz);
+    return numElems;
+  }
+  // Other types have their data at the start (fixed size bytes) or end of each word
+  size_t start = is_fixed_bytes_type(type) ? 0 : ABI_WORD_SZ - sz;
+  for (int i = 0; i < numElems; i++)
+    memcpy((uint8_t *) out + (i * sz), words + (i * ABI_WORD_SZ) + start, sz);
+  return numElems;
+}
+
+int abi_decode_uint_array( void * out,
+                           size_t outSz,
+                           size_t width,
+                           const ABI_t * types,
+                           size_t numTypes,
+                           ABISelector_t info,
+                           const void * in,
+                           size_t inSz)
+{
+  if (!out || !types || !in)
+    return -1;
+  if (width != 1 && width != 2 && width != 4 && width != 8)
+    return -1;
+  if ((info.typeIdx >= numTypes) ||
+      (info.typeIdx >= get_num_root_types(types, numTypes)) ||
+      (!abi_is_valid_schema(types, numTypes)))
+    return -1;
+  ABI_t type = types[info.typeIdx];
+  bool isUint = (type.type >= ABI_UINT8 && type.type <= ABI_UINT256) || type.type == ABI_UINT;
+  if (!isUint)
+    return -1;
+  size_t wordsOff = 0;
+  int numElems = locate_elem_array(types, numTypes, info.typeIdx, in, inSz, &wordsOff);
+  if (numElems < 0 || (size_t) numElems > outSz / width)
+    return -1;
+  if (!narrow_words(out, (const uint8_t *) in + wordsOff, numElems, width))
+    return -1;
+  return numElems;
+}
+
+int abi_decode_tuple_array(void * out,
+                            size_t outSz,
+                            const ABI_t * types,
+                            size_t numTypes,
+                            ABISelector_t tupleInfo,
+                            ABISelector_t paramInfo,
+                            const void * in,
+                            size_t inSz,
+                            uint32_t flags)
+{
+  if (!out || !types || !in)
+    return -1;
+  if (tupleInfo.typeIdx >= numTypes || !is_tuple_type(types[tupleInfo.typeIdx]))
+    return -1;
+  // Treat the tuple as its own definition, as in `abi_decode_tuple_param`
+  int paramIdx = get_first_tuple_param_idx(types, numTypes, tupleInfo.typeIdx);
+  if (paramIdx < 0)
+    return -1;
+  size_t tupleTypeSz = get_tuple_sz(types[tupleInfo.typeIdx]);
+  if (paramInfo.typeIdx >= tupleTypeSz || paramIdx + tupleTypeSz > numTypes)
+    return -1;
+  // `get_tuple_data_start` returns 0 (i.e. a valid offset) for items past the end of the tuple
+  // array or a tuple it cannot locate, so check those first
+  if (get_param_offset(types, numTypes, tupleInfo, in, inSz) > inSz)
+    return -1;
+  if (types[tupleInfo.typeIdx].isArray) {
+    int numItems = abi_get_array_sz(types, numTypes, tupleInfo, in, inSz);
+    if (numItems < 0 || tupleInfo.arrIdx >= (size_t) numItems)
+      return -1;
+  }
+  size_t dataOff = get_tuple_data_start(types, numTypes, tupleInfo, in, inSz);
+  if (dataOff > inSz)
+    return -1;
+  return abi_decode_array(out, 
+                          outSz, 
+                          types + paramIdx, 
+                          tupleTypeSz, 
+                          paramInfo, 
+                          (const uint8_t *) in + dataOff, 
+                          inSz - dataOff, 
+                          flags);
+}
+
+bool abi_is_canonical_payload(const ABI_t * types, size_t numTypes, const void * in, size_t inSz) {
+  if (!types || !in)
+    return false;
+  if (!abi_is_valid_schema(types, numTypes))
+    return false;
+  // Walk every param without an output buffer
+  ABIWalkCtx_t ctx = { .flags = ABI_DECODE_STRICT };
+  return walk_payload(&ctx, types, numTypes, NULL, in, inSz, 0);
+}
+
+int abi_hex_decode(void * out, size_t outSz, const char * hex, size_t hexSz) {
+  if (!out || !hex)
+    return -1;
+  // Skip the optional prefix
+  if (hexSz >= 2 && hex[0] == '0' && (hex[1] | 0x20) == 'x') {
+    hex += 2;
+    hexSz -= 2;
+  }
+  if (hexSz % 2 != 0 || hexSz / 2 > outSz || hexSz / 2 > INT32_MAX)
+    return -1;
+  if (!hex_decode(out, hex, hexSz / 2))
+    return -1;
+  return hexSz / 2;
+}
+
+int abi_hex_encode(char * out, size_t outSz, const void * in, size_t inSz) {
+  if (!out || !in)
+    return -1;
+  if (inSz > (INT32_MAX - 2) / 2 || 2 + (2 * inSz) > outSz)
+    return -1;
+  out[0] = '0';
+  out[1] = 'x';
+  hex_encode(out + 2, in, inSz);
+  return 2 + (2 * inSz);
+}
+
+int abi_hex_encode_column(char * out, 
+                          size_t outSz, 
+                          const void * in, 
+                          size_t elemSz, 
+                          size_t numElems, 
+                          uint32_t flags)
+{
+  if (!out || !in || elemSz == 0)
+    return -1;
+  size_t hexSz = 2 + (2 * elemSz);
+  if (numElems > INT32_MAX / hexSz || numElems * hexSz > outSz)
+    return -1;
+  bool checksum = (flags & ABI_HEX_CHECKSUM) && elemSz == 20;
+  // Convert the whole column at once, leaving room for each element's prefix. Elements
+  // only ever move towards the front, so we can spread them out in place.
+  hex_encode(out + (numElems * 2), in, numElems * elemSz);
+  for (size_t i = 0; i < numElems; i++) {
+    char * elem = out + (i * hexSz);
+    memmove(elem + 2, out + (numElems * 2) + (i * 2 * elemSz), 2 * elemSz);
+    elem[0] = '0';
+    elem[1] = 'x';
+    if (checksum)
+      eip55_checksum(elem + 2);
+  }
+  return numElems * hexSz;
+}
+
+int abi_match_selectors( int * matches, 
+                         const void * const * ins, 
+                         const size_t * inSzs, 
+                         size_t numIns, 
+                         const uint8_t * selectors, 
+                         size_t numSelectors)
+{
+  if (!matches || !ins || !inSzs || !selectors || numSelectors > ABI_MATCH_SELECTORS_MAX)
+    return -1;
+  if (numIns > INT32_MAX)
+    return -1;
+  uint32_t targets[ABI_MATCH_SELECTORS_MAX];
+  memcpy(targets, selectors, numSelectors * ABI_SELECTOR_SZ);
+  return match_selectors(matches, ins, inSzs, numIns, targets, numSelectors);
+}
+
+bool abi_set_kernels(ABIKernelVariant_t variant) {
+  if (variant != ABI_KERNELS_AUTO && !kernels_supported(variant))
+    return false;
+  KERNELS_STORE(&activeKernels, (int) variant);
+  return true;
+}
+
+ABIKernelVariant_t abi_get_kernels(void) {
+  return (ABIKernelVariant_t) get_kernel_variant();
+}
+
+int abi_decode_param_hex( void * out, 
+                          size_t outSz, 
+                          const ABI_t * types, 
+                          size_t numTypes, 
+                          ABISelector_t info, 
+                          const char * hex,
+                          size_t hexSz,
+                          void * scratch,
+                          size_t scratchSz)
+{
+  int inSz = abi_hex_decode(scratch, scratchSz, hex, hexSz);
+  if (inSz < 0)
+    return -1;
+  return abi_decode_param(out, outSz, types, numTypes, info, scratch, inSz);
+}
+
+int abi_decode_batch_hex( void * out,
+                          size_t outSz,
+                          ABIItem_t * items,
+                          size_t numItems,
+                          const ABI_t * types,
+                          size_t numTypes,
+                          const bool * projection,
+                          const char * const * hexIns,
+                          const size_t * hexSzs,
+                          size_t numIns,
+                          int * counts,
+                          uint32_t flags,
+                          void * scratch,
+                          size_t scratchSz)
+{
+  if (!out || !items || !types || !hexIns || !hexSzs || !scratch)
+    return -1;
+  if (!abi_is_valid_schema(types, numTypes))
+    return -1;
+  ABIWalkCtx_t ctx = {
+    .out = out, .outSz = outSz, .items = items, .numItems = numItems, .flags = flags,
+  };
+  // Decoded values are copied out of each payload, so `scratch` is reused for every payload
+  for (size_t i = 0; i < numIns; i++) {
+    int inSz = (hexIns[i] != NULL) ? abi_hex_decode(scratch, scratchSz, hexIns[i], hexSzs[i]) : -1;
+    decode_batch_payload( &ctx, types, numTypes, projection, (inSz >= 0) ? scratch : NULL, 
+                          (inSz >= 0) ? (size_t) inSz : 0, i, counts);
+  }
+  return ctx.itemOff;
+}
+
+bool abi_compile_predicate( ABIPredicate_t * pred,
+                            const ABI_t * types,
+                            size_t numTypes,
+                            const ABICondition_t * conditions,
+                            size_t numConditions)
+{
+  if (!pred || !types || !conditions || numConditions > ABI_PREDICATE_CONDITIONS_MAX)
+    return false;
+  if (!abi_is_valid_schema(types, numTypes))
+    return false;
+  memset(pred, 0, sizeof(ABIPredicate_t));
+  size_t numRoot = get_num_root_types(types, numTypes);
+  for (size_t i = 0; i < numConditions; i++) {
+    ABISelector_t info = conditions[i].info;
+    if (info.typeIdx >= numRoot || conditions[i].cmp > ABI_CMP_GTE)
+      return false;
+    // Only params with a fixed location in the header data can be compared without
+    // reading the payload, i.e. single elementary params and fixed size arrays of them.
+    ABI_t type = types[info.typeIdx];
+    if (!is_single_elementary_type(type) && !is_elementary_type_fixed_sz_array(type))
+      return false;
+    if (type.isArray && info.arrIdx >= type.arraySz)
+      return false;
+    size_t off = get_head_offset(types, numTypes, info.typeIdx);
+    if (off == (size_t) -1)
+      return false;
+    ABICompiledCondition_t * c = &pred->conditions[i];
+    c->off = off + (ABI_WORD_SZ * (type.isArray ? info.arrIdx : 0));
+    c->cmp = conditions[i].cmp;
+    c->isSigned = is_signed_int_type(type);
+    if (!encode_elem_word(c->word, type, conditions[i].val, conditions[i].valSz))
+      return false;
+    if (c->off + ABI_WORD_SZ > pred->minSz)
+      pred->minSz = c->off + ABI_WORD_SZ;
+  }
+  pred->numConditions = numConditions;
+  return true;
+}
+
+bool abi_predicate_matches(const ABIPredicate_t * pred, const void * in, size_t inSz) {
+  if (!pred || !in)
+    return false;
+  return predicate_matches(pred, in, inSz);
+}
+
+int abi_filter_batch( uint8_t * matches,
+                      size_t matchesSz,
+                      const ABIPredicate_t * pred,
+                      const void * const * ins,
+                      const size_t * inSzs,
+                      size_t numIns)
+{
+  if (!matches || !pred || !ins || !inSzs || matchesSz < (numIns + 7) / 8)
+    return -1;
+  memset(matches, 0, (numIns + 7) / 8);
+  int numMatches = 0;
+  for (size_t i = 0; i < numIns; i++) {
+    if (ins[i] && predicate_matches(pred, ins[i], inSzs[i])) {
+      matches[i / 8] |= (1 << (i % 8));
+      numMatches++;
+    }
+  }
+  return numMatches;
+}
+
+int abi_u256_sum(void * out, const void * words, size_t stride, size_t numWords) {
+  if (!out || !words || stride < ABI_WORD_SZ)
+    return -1;
+  uint32_t sum[8] = { 0 };
+  const uint8_t * w = words;
+  while (numWords > 0) {
+    size_t n = numWords < U256_SUM_FLUSH_INTERVAL ? numWords : U256_SUM_FLUSH_INTERVAL;
+    uint64_t acc[8] = { 0 };
+    u256_sum(acc, w, stride, n);
+    if (!u256_sum_flush(sum, acc))
+      return -1;
+    w += n * stride;
+    numWords -= n;
+  }
+  for (size_t c = 0; c < 8; c++)
+    write_u32_be((uint8_t *) out + (4 * c), sum[c]);
+  return 0;
+}
+
+int abi_u256_min(void * out, const void * words, size_t stride, size_t numWords) {
+  if (!out || !words || stride < ABI_WORD_SZ || numWords == 0)
+    return -1;
+  memcpy(out, u256_select(words, stride, numWords, -1), ABI_WORD_SZ);
+  return 0;
+}
+
+int abi_u256_max(void * out, const void * words, size_t stride, size_t numWords) {
+  if (!out || !words || stride < ABI_WORD_SZ || numWords == 0)
+    return -1;
+  memcpy(out, u256_select(words, stride, numWords, 1), ABI_WORD_SZ);
+  return 0;
+}
+
+int abi_u256_count_gt(size_t * count, const void * words, size_t stride, size_t numWords, const void * threshold) {
+  if (!count || !words || !threshold || stride < ABI_WORD_SZ)
+    return -1;
+  *count = u256_count_gt(words, stride, numWords, threshold);
+  return 0;
+}
+
+int abi_encode( void * out, 
+                size_t outSz, 
+                const ABI_t * types, 
+                size_t numTypes, 
+                size_t * offsets, 
+                const void * in, 
+                size_t inSz)
+{
+  if (!out || !types || !offsets || (!in && inSz > 0))
+    return -1;
+  size_t numRoot = get_encodable_root_types(types, numTypes);
+  if (numRoot == 0 || outSz == 0 || outSz > INT32_MAX)
+    return -1;
+  return encode_params(out, outSz, types, numTypes, 0, numRoot, offsets, in, inSz, false);
+}
+
+int abi_encoded_size( const ABI_t * types, 
+                      size_t numTypes, 
+                      size_t * offsets, 
+                      const void * in, 
+                      size_t inSz)
+{
+  if (!types || !offsets || (!in && inSz > 0))
+    return -1;
+  size_t numRoot = get_encodable_root_types(types, numTypes);
+  size_t encSz;
+  if (numRoot == 0 || !get_params_enc_sz(types, numTypes, 0, numRoot, offsets, in, inSz, false, &encSz))
+    return -1;
+  return (encSz > INT32_MAX) ? -1 : (int) encSz;
+}
+
+int abi_encode_values(void * out,
+                      size_t outSz,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      const ABIValue_t * values,
+                      size_t numValues)
+{
+  if (!out || !types || !values)
+    return -1;
+  size_t numRoot = get_encodable_root_types(types, numTypes);
+  if (numRoot == 0 || numValues != numRoot || outSz == 0 || outSz > INT32_MAX)
+    return -1;
+  return encode_params(out, outSz, types, numTypes, 0, numRoot, NULL, values, numValues, true);
+}
+
+int abi_encoded_values_size(const ABI_t * types,
+                            size_t numTypes,
+                            const ABIValue_t * values,
+                            size_t numValues)
+{
+  if (!types || !values)
+    return -1;
+  size_t numRoot = get_encodable_root_types(types, numTypes);
+  size_t encSz;
+  if (numRoot == 0 || numValues != numRoot ||
+      !get_params_enc_sz(types, numTypes, 0, numRoot, NULL, values, numValues, true, &encSz))
+    return -1;
+  return (encSz > INT32_MAX) ? -1 : (int) encSz;
+}
+
+void abi_enc_u64(uint8_t * word, uint64_t v) {
+  memset(word, 0, ABI_WORD_SZ - 8);
+  write_u64_be(word + ABI_WORD_SZ - 8, v);
+}
+
+void abi_enc_i64(uint8_t * word, int64_t v) {
+  memset(word, (v < 0) ? 0xff : 0, ABI_WORD_SZ - 8);
+  write_u64_be(word + ABI_WORD_SZ - 8, (uint64_t) v);
+}
+
+void abi_enc_bool(uint8_t * word, bool v) {
+  memset(word, 0, ABI_WORD_SZ);
+  word[ABI_WORD_SZ - 1] = v ? 1 : 0;
+}
+
+void abi_enc_address(uint8_t * word, const uint8_t * v) {
+  memset(word, 0, ABI_WORD_SZ - ABI_ADDRESS_SZ);
+  memcpy(word + ABI_WORD_SZ - ABI_ADDRESS_SZ, v, ABI_ADDRESS_SZ);
+}
+
+void abi_enc_u256_limbs(uint8_t * word, const uint64_t * v) {
+  for (size_t i = 0; i < 4; i++)
+    write_u64_be(word + (8 * (3 - i)), v[i]);
+}
+
+int abi_get_signature(char * out, 
+                      size_t outSz, 
+                      const char * name, 
+                      const ABI_t * types, 
+                      size_t numTypes)
+{
+  if (!out || !name || outSz == 0 || (!types && numTypes > 0))
+    return -1;
+  if (numTypes > 0 && !abi_is_valid_schema(types, numTypes))
+    return -1;
+  size_t numRoot = numTypes > 0 ? get_num_root_types(types, numTypes) : 0;
+  if (numTypes > 0 && numRoot == 0)
+    return -1;
+  size_t pos = 0;
+  out[0] = '\0';
+  bool ok = sig_append(out, outSz, &pos, name) && sig_append(out, outSz, &pos, "(");
+  for (size_t i = 0; ok && i < numRoot; i++)
+    ok = (i == 0 || sig_append(out, outSz, &pos, ",")) && sig_append_type(out, outSz, &pos, types, numTypes, i);
+  if (!ok || !sig_append(out, outSz, &pos, ")"))
+    return -1;
+  return pos;
+}
+
+bool abi_compile_function(ABIFunction_t * fn, const char * name, const ABI_t * types, size_t numTypes) {
+  if (!fn)
+    return false;
+  char sig[ABI_SIGNATURE_MAX];
+  int sigSz = abi_get_signature(sig, sizeof(sig), name, types, numTypes);
+  if (sigSz < 0)
+    return false;
+  uint8_t hash[32];
+  keccak256(hash, sig, sigSz);
+  fn->types = types;
+  fn->numTypes = numTypes;
+  memcpy(fn->selector, hash, ABI_SELECTOR_SZ);
+  return true;
+}
+
+int abi_encode_call(void * out, 
+                    size_t outSz, 
+                    const ABIFunction_t * fn, 
+                    size_t * offsets, 
+                    const void * in, 
+                    size_t inSz)
+{
+  if (!out || !fn || outSz < ABI_SELECTOR_SZ)
+    return -1;
+  // Functions without params are just their selector
+  int n = 0;
+  if (fn->numTypes > 0)
+    n = abi_encode((uint8_t *) out + ABI_SELECTOR_SZ, outSz - ABI_SELECTOR_SZ, fn->types, fn->numTypes, offsets, in, inSz);
+  else if (inSz > 0)
+    return -1;
+  if (n < 0)
+    return -1;
+  memcpy(out, fn->selector, ABI_SELECTOR_SZ);
+  return ABI_SELECTOR_SZ + n;
+}
+
+int abi_encode_call_values( void * out, 
+                            size_t outSz, 
+                            const ABIFunction_t * fn, 
+                            const ABIValue_t * values, 
+                            size_t numValues)
+{
+  if (!out || !fn || outSz < ABI_SELECTOR_SZ)
+    return -1;
+  int n = 0;
+  if (fn->numTypes > 0)
+    n = abi_encode_values((uint8_t *) out + ABI_SELECTOR_SZ, outSz - ABI_SELECTOR_SZ, fn->types, fn->numTypes, values, numValues);
+  else if (numValues > 0)
+    return -1;
+  if (n < 0)
+    return -1;
+  memcpy(out, fn->selector, ABI_SELECTOR_SZ);
+  return ABI_SELECTOR_SZ + n;
+}
+
+int abi_template_init(ABICallTemplate_t * tpl,
+                      void * buf,
+                      size_t bufSz,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      const uint8_t * selector,
+                      const ABIValue_t * values,
+                      size_t numValues,
+                      const size_t * slotIdxs,
+                      size_t numSlots)
+{
+  if (!tpl || !buf || (!slotIdxs && numSlots > 0) || numSlots > ABI_TEMPLATE_SLOTS_MAX)
+    return -1;
+  size_t prefixSz = selector ? ABI_SELECTOR_SZ : 0;
+  if (bufSz < prefixSz)
+    return -1;
+  int n = abi_encode_values((uint8_t *) buf + prefixSz, bufSz - prefixSz, types, numTypes, values, numValues);
+  if (n < 0)
+    return -1;
+  if (selector)
+    memcpy(buf, selector, ABI_SELECTOR_SZ);
+  const uint8_t * params = (const uint8_t *) buf + prefixSz;
+  memset(tpl, 0, sizeof(ABICallTemplate_t));
+  tpl->types = types;
+  tpl->numTypes = numTypes;
+  tpl->payload = buf;
+  tpl->sz = prefixSz + n;
+  tpl->prefixSz = prefixSz;
+  tpl->headSz = get_params_head_sz(types, numTypes, 0, numValues);
+  tpl->numSlots = numSlots;
+  for (size_t i = 0; i < numSlots; i++) {
+    size_t idx = slotIdxs[i];
+    if (idx >= numValues || (i > 0 && idx <= slotIdxs[i-1]))
+      return -1;
+    ABITemplateSlot_t * slot = &tpl->slots[i];
+    slot->typeIdx = idx;
+    slot->headOff = get_params_head_sz(types, numTypes, 0, idx);
+    slot->isDynamic = is_dynamic_param(types, numTypes, idx);
+    if (!slot->isDynamic)
+      continue;
+    // Tails are in param order, so this param's data runs up to the next dynamic param's data
+    slot->tailOff = get_abi_u32_be(params, slot->headOff);
+    size_t tailEnd = n;
+    size_t headOff = slot->headOff + ABI_WORD_SZ;
+    for (size_t j = idx + 1; j < numValues; j++) {
+      if (is_dynamic_param(types, numTypes, j)) {
+        tailEnd = get_abi_u32_be(params, headOff);
+        break;
+      }
+      headOff += get_param_head_sz(types, numTypes, j);
+    }
+    slot->tailSz = tailEnd - slot->tailOff;
+  }
+  return tpl->sz;
+}
+
+int abi_template_encode(void * out,
+                        size_t outSz,
+                        const ABICallTemplate_t * tpl,
+                        const ABIValue_t * slotValues)
+{
+  if (!out || !tpl || !tpl->payload || (!slotValues && tpl->numSlots > 0) ||
+      tpl->numSlots > ABI_TEMPLATE_SLOTS_MAX)
+    return -1;
+  const ABI_t * types = tpl->types;
+  size_t numTypes = tpl->numTypes;
+  // Size the new data of the dynamic slots; the static slots always fit their head
+  size_t slotSzs[ABI_TEMPLATE_SLOTS_MAX];
+  size_t sz = tpl->sz;
+  bool resized = false;
+  for (size_t i = 0; i < tpl->numSlots; i++) {
+    const ABITemplateSlot_t * slot = &tpl->slots[i];
+    if (!slotValues[i].ptr && slotValues[i].len > 0)
+      return -1;
+    if (!slot->isDynamic)
+      continue;
+    if (!get_value_enc_sz(types, numTypes, slot->typeIdx, slotValues[i].ptr, slotValues[i].len, true, &slotSzs[i]))
+      return -1;
+    sz = sz - slot->tailSz + slotSzs[i];
+    resized |= (slotSzs[i] != slot->tailSz);
+  }
+  if (sz > outSz || sz > INT32_MAX)
+    return -1;
+  const uint8_t * src = tpl->payload + tpl->prefixSz;
+  uint8_t * dst = (uint8_t *) out + tpl->prefixSz;
+  size_t paramsSz = tpl->sz - tpl->prefixSz;
+  if (!resized) {
+    memcpy(out, tpl->payload, tpl->sz);
+  } else {
+    // Copy the head, moving the offset of every dynamic param after a resized slot
+    memcpy(out, tpl->payload, tpl->prefixSz + tpl->headSz);
+    size_t numRoot = get_num_root_types(types, numTypes);
+    size_t grown = 0, shrunk = 0, headOff = 0, k = 0;
+    for (size_t j = 0; j < numRoot; j++) {
+      for (; k < tpl->numSlots && tpl->slots[k].typeIdx < j; k++) {
+        if (tpl->slots[k].isDynamic) {
+          grown += slotSzs[k];
+          shrunk += tpl->slots[k].tailSz;
+        }
+      }
+      if (is_dynamic_param(types, numTypes, j) &&
+          !encode_u32_word(dst + headOff, get_abi_u32_be(src, headOff) + grown - shrunk))
         return -1;
-      _sz = offsets[i+1] - _off;
-    } else {
-      // Last offset can be compared against inSz
-      _sz = inSz - _off;
+      headOff += get_param_head_sz(types, numTypes, j);
+    }
+    // Copy the constant tails between the dynamic slots, which are written as we go
+    size_t srcOff = tpl->headSz, dstOff = tpl->headSz;
+    for (size_t i = 0; i < tpl->numSlots; i++) {
+      const ABITemplateSlot_t * slot = &tpl->slots[i];
+      if (!slot->isDynamic)
+        continue;
+      memcpy(dst + dstOff, src + srcOff, slot->tailOff - srcOff);
+      dstOff += slot->tailOff - srcOff;
+      if (encode_value(dst + dstOff, slotSzs[i], types, numTypes, slot->typeIdx, 
+                       slotValues[i].ptr, slotValues[i].len, true) < 0)
+        return -1;
+      dstOff += slotSzs[i];
+      srcOff = slot->tailOff + slot->tailSz;
     }
+    memcpy(dst + dstOff, src + srcOff, paramsSz - srcOff);
+  }
+  // Patch the remaining slots in place
+  for (size_t i = 0; i < tpl->numSlots; i++) {
+    const ABITemplateSlot_t * slot = &tpl->slots[i];
+    if (slot->isDynamic && resized)
+      continue;
+    size_t off = slot->isDynamic ? slot->tailOff : slot->headOff;
+    size_t slotSz = slot->isDynamic ? slot->tailSz : get_static_sz(types, numTypes, slot->typeIdx);
+    if (encode_value(dst + off, slotSz, types, numTypes, slot->typeIdx, 
+                     slotValues[i].ptr, slotValues[i].len, true) < 0)
+      return -1;
+  }
+  return sz;
+}
 
-    // Avoid overrunning the buffer
-    if ((ABI_WORD_SZ * i) + _sz > outSz)
+int abi_patch_param(void * buf,
+                    size_t bufSz,
+                    size_t sz,
+                    const ABI_t * types,
+                    size_t numTypes,
+                    ABISelector_t info,
+                    const void * val,
+                    size_t valSz)
+{
+  if (!buf || sz > bufSz || (!val && valSz > 0))
+    return -1;
+  size_t numRoot = get_encodable_root_types(types, numTypes);
+  if (info.typeIdx >= numRoot || is_tuple_type(types[info.typeIdx]))
+    return -1;
+  ABI_t type = types[info.typeIdx];
+  uint8_t * data = buf;
+  size_t paramOff = get_param_offset(types, numTypes, info, data, sz);
+  if (paramOff > sz)
+    return -1;
+  size_t dataOff = 0;
+  int n = locate_param(type, data, sz, paramOff, info, &dataOff);
+  if (n < 0)
+    return -1;
+  // Static values (including elements of elementary arrays) are overwritten in place
+  if (is_elementary_atomic_type(type)) {
+    size_t wordOff = is_fixed_bytes_type(type) ? dataOff : dataOff + n - ABI_WORD_SZ;
+    if (wordOff + ABI_WORD_SZ > sz || !encode_elem_word(data + wordOff, type, val, valSz))
+      return -1;
+    return sz;
+  }
+  // Dynamic data is replaced and everything after it is shifted by the change in its padded size
+  size_t lenOff = dataOff - ABI_WORD_SZ;
+  size_t oldPadSz = ABI_WORD_SZ * ((n + ABI_WORD_SZ - 1) / ABI_WORD_SZ);
+  size_t newPadSz = ABI_WORD_SZ * ((valSz + ABI_WORD_SZ - 1) / ABI_WORD_SZ);
+  size_t tailEnd = dataOff + oldPadSz;
+  if (tailEnd > sz || valSz > UINT32_MAX || newPadSz > bufSz || sz - oldPadSz > bufSz - newPadSz)
+    return -1;
+  size_t newSz = sz - oldPadSz + newPadSz;
+  if (newSz > INT32_MAX)
+    return -1;
+  // The offsets we may rewrite (the head and this array's offset table) must precede the data
+  size_t tableOff = paramOff + (is_variable_sz_array(type) ? ABI_WORD_SZ : 0);
+  size_t numElems = 0;
+  if (is_dynamic_type_array(type))
+    numElems = is_variable_sz_array(type) ? get_abi_u32_be(data, paramOff) : type.arraySz;
+  if (get_params_head_sz(types, numTypes, 0, numRoot) > lenOff || 
+      (numElems > 0 && tableOff + (ABI_WORD_SZ * numElems) > lenOff))
+    return -1;
+  memmove(data + dataOff + newPadSz, data + tailEnd, sz - tailEnd);
+  encode_dynamic_data(data + lenOff, val, valSz);
+  if (newPadSz == oldPadSz)
+    return newSz;
+  size_t headOff = 0;
+  for (size_t j = 0; j < numRoot; j++) {
+    if (is_dynamic_param(types, numTypes, j) && 
+        !shift_offset(data, headOff, 0, tailEnd, newPadSz, oldPadSz))
       return -1;
+    headOff += get_param_head_sz(types, numTypes, j);
+  }
+  for (size_t k = 0; k < numElems; k++) {
+    if (!shift_offset(data, tableOff + (ABI_WORD_SZ * k), tableOff, tailEnd, newPadSz, oldPadSz))
+      return -1;
+  }
+  return newSz;
+}
 
-    // Write the param
-    if (is_dynamic_atomic_type(types[i])) {
-      // Dynamic types go at the end of the buffer
-      // Write the offset in the buffer in this slot (in big endian)
-      size_t dynamicDataOff = (size_t) ABI_WORD_SZ * (numTypes + dynamicCount);
-      write_u32_be((loc+ABI_WORD_SZ-4), dynamicDataOff);
-      // Write the data size at the edge of teh buffer
-      write_u32_be((out+dynamicDataOff+ABI_WORD_SZ-4), _sz);
-      // Write the data at the end of the buffer
-      memcpy((out+dynamicDataOff+ABI_WORD_SZ), in+_off, _sz);
-      // Account for the number of words we just wrote. If the data exceeds one word,
-      // it will wrap into another.
-      size_t numWords = 2 + (_sz / ABI_WORD_SZ); // 2 accounts for the size word
-      dynamicCount += numWords;
-      numWritten += numWords * ABI_WORD_SZ;
+int abi_encode_packed(void * out,
+                      size_t outSz,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      const ABIValue_t * values,
+                      size_t numValues)
+{
+  if (!out || !values || numValues != numTypes || outSz > INT32_MAX || !is_packable_schema(types, numTypes))
+    return -1;
+  uint8_t * dst = out;
+  size_t off = 0;
+  for (size_t i = 0; i < numTypes; i++) {
+    ABI_t type = types[i];
+    const ABIValue_t * v = &values[i];
+    if (!v->ptr && v->len > 0)
+      return -1;
+    if (type.isArray) {
+      // Elements are padded to whole words, and variable size arrays have no length prefix
+      if ((is_fixed_sz_array(type) && v->len != type.arraySz) || v->len > (outSz - off) / ABI_WORD_SZ)
+        return -1;
+      const ABIValue_t * elems = v->ptr;
+      for (size_t j = 0; j < v->len; j++) {
+        if ((!elems[j].ptr && elems[j].len > 0) || 
+            !encode_elem_word(dst + off, type, elems[j].ptr, elems[j].len))
+          return -1;
+        off += ABI_WORD_SZ;
+      }
+    } else if (is_dynamic_atomic_type(type)) {
+      if (v->len > outSz - off)
+        return -1;
+      memcpy(dst + off, v->ptr, v->len);
+      off += v->len;
     } else {
-      // All other params are written to the location
-      // Bytes types are written to the front of the word. All others are left padded.
-      size_t outOff = 0;
-      if (!is_fixed_bytes_type(types[i]))
-        outOff += (ABI_WORD_SZ - _sz);
-      memcpy((loc+outOff), (in+_off), _sz);
+      size_t w = packed_elem_sz(type);
+      if (w > outSz - off || !encode_packed_elem(dst + off, type, v->ptr, v->len))
+        return -1;
+      off += w;
+    }
+  }
+  return off;
+}
+
+int abi_decode_packed_param(void * out,
+                            size_t outSz,
+                            const ABI_t * types,
+                            size_t numTypes,
+                            ABISelector_t info,
+                            const void * in,
+                            size_t inSz)
+{
+  if (!out || !in || !is_packable_schema(types, numTypes) || info.typeIdx >= numTypes)
+    return -1;
+  // The layout is fixed by the schema, except for one dynamic param which gets the remaining bytes
+  size_t staticSz = 0, numDynamic = 0;
+  bool isDynamicArray = false;
+  for (size_t i = 0; i < numTypes; i++) {
+    size_t sz = get_packed_param_sz(types[i]);
+    if (sz == 0) {
+      numDynamic++;
+      isDynamicArray = types[i].isArray;
     }
-    numWritten += ABI_WORD_SZ;
+    staticSz += sz;
+  }
+  if (numDynamic > 1 || staticSz > inSz || (numDynamic == 0 && staticSz != inSz))
+    return -1;
+  size_t dynamicSz = inSz - staticSz;
+  if (isDynamicArray && dynamicSz % ABI_WORD_SZ != 0)
+    return -1;
+  size_t off = 0;
+  for (size_t i = 0; i < info.typeIdx; i++) {
+    size_t sz = get_packed_param_sz(types[i]);
+    off += (sz == 0) ? dynamicSz : sz;
+  }
+  ABI_t type = types[info.typeIdx];
+  const uint8_t * src = (const uint8_t *) in + off;
+  if (type.isArray) {
+    // Elements are returned without their padding, as by `abi_decode_param`
+    size_t sz = get_packed_param_sz(type);
+    if (sz == 0)
+      sz = dynamicSz;
+    if (info.arrIdx >= sz / ABI_WORD_SZ)
+      return -1;
+    size_t dataOff = 0;
+    int n = locate_elem_param(type, inSz, off + (ABI_WORD_SZ * info.arrIdx), &dataOff);
+    if (n < 0 || (size_t) n > outSz)
+      return -1;
+    memcpy(out, (const uint8_t *) in + dataOff, n);
+    return n;
+  } else if (is_dynamic_atomic_type(type)) {
+    if (dynamicSz > outSz)
+      return -1;
+    memcpy(out, src, dynamicSz);
+    return dynamicSz;
   }
+  // Signed integers are sign extended to a whole word, as by `abi_decode_param`
+  size_t w = packed_elem_sz(type);
+  size_t n = elem_sz(type);
+  if (n > outSz)
+    return -1;
+  memset(out, (is_signed_int_type(type) && (src[0] & 0x80)) ? 0xff : 0, n - w);
+  memcpy((uint8_t *) out + n - w, src, w);
+  return n;
+}
+
+int abi_calldata_stats(ABICalldataStats_t * stats, const void * in, size_t inSz) {
+  if (!stats || (!in && inSz > 0))
+    return -1;
+  memset(stats, 0, sizeof(ABICalldataStats_t));
+  calldata_stats(stats, in, inSz);
+  stats->nonzeroBytes = inSz - stats->zeroBytes;
+  set_calldata_gas(stats);
+  return 0;
+}
+
+int abi_encode_with_stats(void * out, 
+                          size_t outSz, 
+                          const ABI_t * types, 
+                          size_t numTypes, 
+                          size_t * offsets, 
+                          const void * in, 
+                          size_t inSz,
+                          ABICalldataStats_t * stats)
+{
+  int n = abi_encode(out, outSz, types, numTypes, offsets, in, inSz);
+  // The payload was just written, so it is still in cache for the scan
+  if (n > 0 && stats && abi_calldata_stats(stats, out, n) < 0)
+    return -1;
+  return n;
+}
 
-  return numWritten;
-}
\ No newline at end of file
+int abi_encode_call_with_stats( void * out, 
+                                size_t outSz, 
+                                const ABIFunction_t * fn, 
+                                size_t * offsets, 
+                                const void * in, 
+                                size_t inSz,
+                                ABICalldataStats_t * stats)
+{
+  int n = abi_encode_call(out, outSz, fn, offsets, in, inSz);
+  if (n <= 0 || !stats)
+    return n;
+  // Words are those of the params; the selector bytes only count towards the gas
+  const uint8_t * selector = out;
+  if (abi_calldata_stats(stats, selector + ABI_SELECTOR_SZ, n - ABI_SELECTOR_SZ) < 0)
+    return -1;
+  for (size_t i = 0; i < ABI_SELECTOR_SZ; i++) {
+    if (selector[i] == 0)
+      stats->zeroBytes++;
+    else
+      stats->nonzeroBytes++;
+  }
+  set_calldata_gas(stats);
+  return n;
+}
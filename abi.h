@@ -34,9 +34,13 @@
 #define __ETHEREUM_ABI_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #define ABI_WORD_SZ 32
+#define ABI_SELECTOR_SZ 4
+#define ABI_ADDRESS_SZ 20
+#define ABI_MATCH_SELECTORS_MAX 16
 #define ABI_ARRAY_DEPTH_MAX 2
 #pragma pack(push,1)
 // Enumeration of ABI types.
@@ -193,6 +197,144 @@ typedef struct {
 } ABISelector_t;
 #pragma pack(pop)
 
+// Description of a single value written by the walk decoders (`abi_decode_walk`, `abi_decode_batch`).
+// Array params produce one item per element and tuple arrays produce one item per element
+// of each nested param in each tuple item.
+typedef struct {
+  size_t payloadIdx;                  // Index of the payload the value was decoded from (batch only)
+  size_t typeIdx;                     // Index of the param in the flattened schema (`types`)
+  bool isTupleParam;                  // Whether this param is nested in a tuple
+  ABISelector_t tupleInfo;            // The tuple item containing this param (if `isTupleParam`)
+  ABISelector_t info;                 // Selector for this value (relative to the tuple if `isTupleParam`)
+  size_t off;                         // Offset of the decoded data in the output buffer
+  size_t sz;                          // Size of the decoded data
+} ABIItem_t;
+
+// Options for the bulk decoders (e.g. `abi_decode_array`), combined as a bitmask.
+typedef enum {
+  ABI_DECODE_DEFAULT = 0,
+  ABI_DECODE_STRICT = (1 << 0),       // Reject values which are not canonically padded (see `abi_is_canonical_payload`)
+  ABI_DECODE_NATIVE_ENDIAN = (1 << 1),// Write `uintN`/`intN` values as native endian integers of the decoded size
+  ABI_DECODE_BITSET = (1 << 2),       // Pack `bool[]` arrays into bitsets, rejecting bools other than 0 or 1
+} ABIDecodeFlags_t;
+
+// Options for `abi_hex_encode_column`
+typedef enum {
+  ABI_HEX_DEFAULT = 0,
+  ABI_HEX_CHECKSUM = (1 << 0),        // Write 20 byte values (i.e. addresses) with EIP-55 checksum casing
+} ABIHexFlags_t;
+
+// Variants of the vectorized kernels, which every function in this library that scans data in bulk
+// (array decoding, padding checks, hex conversion, selector matching, aggregations and calldata
+// statistics) runs on. By default the best variant the CPU supports is detected on first use; set
+// the `ABI_FORCE_SCALAR` environment variable to use the scalar kernels instead. Non-x86 builds
+// only have the scalar kernels. Every variant gives the same results.
+typedef enum {
+  ABI_KERNELS_AUTO = 0,               // Detect the best supported variant
+  ABI_KERNELS_SCALAR,                 // Portable C
+  ABI_KERNELS_SSSE3,                  // SSSE3 where available, scalar otherwise
+  ABI_KERNELS_AVX2,                   // AVX2 (also used on AVX-512 machines)
+} ABIKernelVariant_t;
+
+// Calldata gas per byte (EIP-2028)
+#define ABI_CALLDATA_ZERO_BYTE_GAS 4
+#define ABI_CALLDATA_NONZERO_BYTE_GAS 16
+
+// Statistics of a calldata payload (see `abi_calldata_stats`)
+typedef struct {
+  size_t zeroBytes;                   // Number of zero bytes
+  size_t nonzeroBytes;                // Number of nonzero bytes
+  size_t zeroWords;                   // Number of 32 byte words (aligned to the start of the payload) which are all zero
+  size_t zeroWordRuns;                // Number of runs of consecutive all-zero words
+  uint64_t gas;                       // Intrinsic gas of the calldata bytes
+} ABICalldataStats_t;
+
+// A value to encode with `abi_encode_values`, read from where it already lives.
+// * Elementary and dynamic values (e.g. `uint256`, `bytes`) point to their data, in the same format
+//   `abi_decode_param` returns
+// * Arrays point to a list of `len` descriptors, one per element
+// * Tuples point to a list of `len` descriptors, one per param (so arrays of tuples point to a
+//   list of tuple descriptors)
+typedef struct {
+  const void * ptr;                   // Value data, or a list of descriptors for arrays and tuples
+  size_t len;                         // Size of the data, or number of descriptors in the list
+} ABIValue_t;
+
+// Longest function signature `abi_compile_function` can hash
+#define ABI_SIGNATURE_MAX 1024
+
+// A function schema compiled with `abi_compile_function`. Its selector is computed once, when it
+// is compiled, so encoding a call never hashes anything.
+typedef struct {
+  const ABI_t * types;                // All types in the function's ABI definition
+  size_t numTypes;                    // Number of types in the definition (0 for functions without params)
+  uint8_t selector[ABI_SELECTOR_SZ];  // First 4 bytes of the keccak256 hash of the signature
+} ABIFunction_t;
+
+#define ABI_TEMPLATE_SLOTS_MAX 8
+
+// A variable param of a call template (see `abi_template_init`). Offsets are relative to the
+// start of the params (i.e. after the selector).
+typedef struct {
+  size_t typeIdx;                     // Root param this slot replaces
+  bool isDynamic;                     // Whether the param is represented by an offset in the head
+  size_t headOff;                     // Offset of the param's head (its value, or its offset word if dynamic)
+  size_t tailOff;                     // Offset of the param's data in the template (dynamic params only)
+  size_t tailSz;                      // Size of the param's data in the template (dynamic params only)
+} ABITemplateSlot_t;
+
+// A call pre-encoded with `abi_template_init`. Only the slots change between calls.
+typedef struct {
+  const ABI_t * types;
+  size_t numTypes;
+  const uint8_t * payload;            // Pre-encoded payload, i.e. the selector (if any) and the params
+  size_t sz;                          // Size of `payload`
+  size_t prefixSz;                    // Size of the selector at the start of `payload` (0 if there is none)
+  size_t headSz;                      // Size of the head of the params
+  size_t numSlots;
+  ABITemplateSlot_t slots[ABI_TEMPLATE_SLOTS_MAX];
+} ABICallTemplate_t;
+
+#define ABI_PREDICATE_CONDITIONS_MAX 8
+
+// Comparison operators for predicates. Words are compared as big endian numbers (two's complement
+// for signed types); fixed size bytes types are compared lexicographically.
+typedef enum {
+  ABI_CMP_EQ = 0,
+  ABI_CMP_NE,
+  ABI_CMP_LT,
+  ABI_CMP_LTE,
+  ABI_CMP_GT,
+  ABI_CMP_GTE,
+} ABICmp_t;
+
+// A condition on a single param, i.e. `<param> <cmp> <val>`.
+// `val` is in the same format returned by `abi_decode_param` (e.g. 20 bytes for an address,
+// 1 byte for a bool, big endian numbers of up to the type size).
+typedef struct {
+  ABISelector_t info;                 // The param (and array element, if applicable) to compare
+  ABICmp_t cmp;                       // Comparison to perform
+  const void * val;                   // Value to compare the param against
+  size_t valSz;                       // Size of `val`
+} ABICondition_t;
+
+// A condition resolved against a schema. The param's word offset is known and the value
+// has been encoded into a 32-byte word so it can be compared directly with payload data.
+typedef struct {
+  size_t off;                         // Offset of the param's word in the payload
+  ABICmp_t cmp;
+  bool isSigned;
+  uint8_t word[ABI_WORD_SZ];          // Encoded value to compare against
+} ABICompiledCondition_t;
+
+// A set of conditions compiled with `abi_compile_predicate`. A payload matches if it
+// meets every condition.
+typedef struct {
+  size_t numConditions;
+  size_t minSz;                       // Smallest payload which contains every compared word
+  ABICompiledCondition_t conditions[ABI_PREDICATE_CONDITIONS_MAX];
+} ABIPredicate_t;
+
 // Helper to determine if this is a tuple type
 bool is_tuple_type(ABI_t t);
 
@@ -282,14 +424,344 @@ int abi_decode_tuple_param( void * out,
                             const void * in,
                             size_t inSz);
 
+// Decode every projected param of a payload in a single pass. Decoded data is tightly packed into
+// `out` (with padding stripped, as in `abi_decode_param`) and each value is described by an item.
+// The projection is a mask over the flattened schema, i.e. `projection[i]` corresponds to `types[i]`
+// and may select params nested in tuples. Projecting a tuple projects all of its params.
+// Params which are not projected are skipped entirely -- we do not copy them, read their
+// sizes, or follow their offsets.
+// @param `out`        - output buffer to be written
+// @param `outSz`      - size of output buffer to be written
+// @param `items`      - output item descriptions
+// @param `numItems`   - capacity of `items`
+// @param `types`      - all types in the larger ABI definition
+// @param `numTypes`   - number of types in the larger ABI definition
+// @param `projection` - list of size `numTypes` of params to decode (NULL decodes every param)
+// @param `in`         - Buffer containin the input data
+// @param `inSz`       - Size of `in`
+// @param `flags`      - bitmask of `ABIDecodeFlags_t` options
+// @return             - number of items written to `items`; -1 on error.
+int abi_decode_walk(void * out,
+                    size_t outSz,
+                    ABIItem_t * items,
+                    size_t numItems,
+                    const ABI_t * types,
+                    size_t numTypes,
+                    const bool * projection,
+                    const void * in,
+                    size_t inSz,
+                    uint32_t flags);
+
+// Perform `abi_decode_walk` on a batch of payloads which share a schema. The schema is validated
+// once for the whole batch. Items from all payloads are written to `items` in payload order and
+// tagged with `payloadIdx`. A payload which cannot be decoded (e.g. it is malformed or there is
+// no space left in the output buffers) contributes no items.
+// @param `out`        - output buffer to be written
+// @param `outSz`      - size of output buffer to be written
+// @param `items`      - output item descriptions
+// @param `numItems`   - capacity of `items`
+// @param `types`      - all types in the larger ABI definition
+// @param `numTypes`   - number of types in the larger ABI definition
+// @param `projection` - list of size `numTypes` of params to decode (NULL decodes every param)
+// @param `ins`        - list of size `numIns` of payloads
+// @param `inSzs`      - list of size `numIns` of payload sizes
+// @param `numIns`     - number of payloads
+// @param `counts`     - (optional) list of size `numIns` to be filled with the number of items
+//                       decoded from each payload, or -1 if the payload could not be decoded
+// @param `flags`      - bitmask of `ABIDecodeFlags_t` options
+// @return             - total number of items written to `items`; -1 on error.
+int abi_decode_batch( void * out,
+                      size_t outSz,
+                      ABIItem_t * items,
+                      size_t numItems,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      const bool * projection,
+                      const void * const * ins,
+                      const size_t * inSzs,
+                      size_t numIns,
+                      int * counts,
+                      uint32_t flags);
+
+// Decode every element of an elementary type array (fixed or variable size) in one call.
+// Elements are tightly packed into `out` at their decoded size (e.g. 20 bytes per address),
+// in the same format `abi_decode_param` returns for each element. Strict mode padding checks
+// run over all elements at once. Only root params are supported (see `abi_decode_tuple_array` for arrays nested in tuples).
+// With `ABI_DECODE_BITSET`, a `bool[]` is instead packed into `(N + 7) / 8` bytes, where bit `i % 8`
+// of `out[i / 8]` is element `i`.
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `types`     - all types in the larger ABI definition
+// @param `numTypes`  - number of types in the larger ABI definition
+// @param `info`      - the array param to decode (`arrIdx` is ignored)
+// @param `in`        - Buffer containin the input data
+// @param `inSz`      - Size of `in`
+// @param `flags`     - bitmask of `ABIDecodeFlags_t` options
+// @return            - number of elements written to `out`; -1 on error.
+int abi_decode_array( void * out,
+                      size_t outSz,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      ABISelector_t info,
+                      const void * in,
+                      size_t inSz,
+                      uint32_t flags);
+
+// Decode every element of an unsigned integer array (`uintN[]` or `uintN[M]`) into an array of native
+// integers of `width` bytes, e.g. `uint64_t[]` for `width = 8`. Elements of any `uintN` type may be
+// narrowed (or widened), as long as each value fits in `width` bytes. Only root params are supported.
+// @param `out`       - output array of native integers to be written
+// @param `outSz`     - size of `out` in bytes
+// @param `width`     - size of each output integer in bytes (1, 2, 4, or 8)
+// @param `types`     - all types in the larger ABI definition
+// @param `numTypes`  - number of types in the larger ABI definition
+// @param `info`      - the array param to decode (`arrIdx` is ignored)
+// @param `in`        - Buffer containin the input data
+// @param `inSz`      - Size of `in`
+// @return            - number of elements written to `out`; -1 on error or if any value
+//                      does not fit in `width` bytes.
+int abi_decode_uint_array( void * out,
+                           size_t outSz,
+                           size_t width,
+                           const ABI_t * types,
+                           size_t numTypes,
+                           ABISelector_t info,
+                           const void * in,
+                           size_t inSz);
+
+// Perform `abi_decode_array` on an array param nested in a tuple.
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `types`     - all types in the larger ABI definition
+// @param `numTypes`  - number of types in the larger ABI definition
+// @param `tupleInfo` - information about the tuple param (i.e. one of the root params)
+// @param `paramInfo` - the array param inside the tuple (`arrIdx` is ignored)
+// @param `in`        - Buffer containin the input data
+// @param `inSz`      - Size of `in`
+// @param `flags`     - bitmask of `ABIDecodeFlags_t` options
+// @return            - number of elements written to `out`; -1 on error.
+int abi_decode_tuple_array(void * out,
+                            size_t outSz,
+                            const ABI_t * types,
+                            size_t numTypes,
+                            ABISelector_t tupleInfo,
+                            ABISelector_t paramInfo,
+                            const void * in,
+                            size_t inSz,
+                            uint32_t flags);
+
+// Check that every value in a payload is canonically encoded, i.e. has the padding a conforming
+// encoder would write. This is the check `ABI_DECODE_STRICT` performs on each decoded value:
+// * `uintN`, `address` and `bool` words are left-padded with zeros (and bools are 0 or 1)
+// * `intN` words are sign extended
+// * `bytesN` words are right-padded with zeros
+// * `bytes` and `string` data is right-padded with zeros to a multiple of 32 bytes, and its size fits in 32 bits
+// @param `types`     - all types in the larger ABI definition
+// @param `numTypes`  - number of types in the larger ABI definition
+// @param `in`        - Buffer containin the input data
+// @param `inSz`      - Size of `in`
+// @return            - true if the payload can be decoded and every value is canonical
+bool abi_is_canonical_payload(const ABI_t * types, size_t numTypes, const void * in, size_t inSz);
+
+// Convert a hex string (e.g. calldata from JSON-RPC) into bytes. The string may have a `0x` prefix
+// and digits may be either case.
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `hex`       - hex string (need not be NULL terminated)
+// @param `hexSz`     - number of characters in `hex`
+// @return            - number of bytes written to `out`; -1 on error (including an odd number of
+//                      digits or a character which is not a hex digit).
+int abi_hex_decode(void * out, size_t outSz, const char * hex, size_t hexSz);
+
+// Perform `abi_decode_param` on a hex encoded payload. The payload is converted into `scratch`,
+// which must be large enough to hold it.
+// @param `hex`       - hex string of the payload, i.e. what `in` would be for `abi_decode_param`
+// @param `hexSz`     - number of characters in `hex`
+// @param `scratch`   - buffer for the converted payload
+// @param `scratchSz` - size of `scratch`
+// Other params and the return value are the same as `abi_decode_param`.
+int abi_decode_param_hex( void * out, 
+                          size_t outSz, 
+                          const ABI_t * types, 
+                          size_t numTypes, 
+                          ABISelector_t info, 
+                          const char * hex,
+                          size_t hexSz,
+                          void * scratch,
+                          size_t scratchSz);
+
+// Perform `abi_decode_batch` on hex encoded payloads. Each payload is converted into `scratch`
+// before it is decoded, so `scratch` only needs to be large enough to hold the largest payload.
+// Payloads which are not valid hex (or do not fit in `scratch`) are skipped like malformed payloads.
+// @param `hexIns`    - list of size `numIns` of hex strings of payloads
+// @param `hexSzs`    - list of size `numIns` of the number of characters in each hex string
+// @param `scratch`   - buffer for the converted payloads
+// @param `scratchSz` - size of `scratch`
+// Other params and the return value are the same as `abi_decode_batch`.
+int abi_decode_batch_hex( void * out,
+                          size_t outSz,
+                          ABIItem_t * items,
+                          size_t numItems,
+                          const ABI_t * types,
+                          size_t numTypes,
+                          const bool * projection,
+                          const char * const * hexIns,
+                          const size_t * hexSzs,
+                          size_t numIns,
+                          int * counts,
+                          uint32_t flags,
+                          void * scratch,
+                          size_t scratchSz);
+
+// Convert bytes (e.g. an encoded payload) into a `0x` prefixed lowercase hex string.
+// @param `out`       - output buffer to be written; needs `2 + 2 * inSz` characters. No NULL
+//                      terminator is written.
+// @param `outSz`     - size of output buffer to be written
+// @param `in`        - bytes to convert
+// @param `inSz`      - size of `in`
+// @return            - number of characters written to `out`; -1 on error
+int abi_hex_encode(char * out, size_t outSz, const void * in, size_t inSz);
+
+// Convert a column of fixed size values (e.g. the output of `abi_decode_array`) into hex strings.
+// Each value is written as a `0x` prefixed string of `2 + 2 * elemSz` characters, back to back
+// with no separators or NULL terminators. The whole column is converted in one pass.
+// @param `out`       - output buffer to be written; needs `numElems * (2 + 2 * elemSz)` characters
+// @param `outSz`     - size of output buffer to be written
+// @param `in`        - packed values
+// @param `elemSz`    - size of each value in `in`
+// @param `numElems`  - number of values in `in`
+// @param `flags`     - `ABIHexFlags_t` options. `ABI_HEX_CHECKSUM` only applies when `elemSz` is 20.
+// @return            - number of characters written to `out`; -1 on error
+int abi_hex_encode_column(char * out, 
+                          size_t outSz, 
+                          const void * in, 
+                          size_t elemSz, 
+                          size_t numElems, 
+                          uint32_t flags);
+
+// Match the 4-byte selectors prefixing a batch of payloads (e.g. transaction calldata) against
+// a set of known selectors. Each payload's selector is compared against every target at once,
+// so unknown calls can be dropped before any decoding is done.
+// @param `matches`      - list of size `numIns` to be written with the index of the first
+//                         matching selector for each payload, or -1 if none match (including
+//                         payloads shorter than a selector)
+// @param `ins`          - list of size `numIns` of payloads, each starting with its selector
+// @param `inSzs`        - list of size `numIns` of payload sizes
+// @param `numIns`       - number of payloads
+// @param `selectors`    - packed list of `numSelectors` 4-byte selectors
+// @param `numSelectors` - number of selectors (at most `ABI_MATCH_SELECTORS_MAX`)
+// @return               - number of payloads which matched a selector; -1 on error
+int abi_match_selectors( int * matches, 
+                         const void * const * ins, 
+                         const size_t * inSzs, 
+                         size_t numIns, 
+                         const uint8_t * selectors, 
+                         size_t numSelectors);
+
+// Compile a set of conditions on a schema into a predicate which can be evaluated directly on
+// encoded payloads, i.e. without decoding them. Word offsets are resolved and values are encoded
+// once here. Conditions may only refer to params which live at a fixed location in the header data,
+// i.e. single elementary params or elements of fixed size elementary arrays which are not nested
+// in tuples.
+// @param `pred`          - predicate to be written
+// @param `types`         - all types in the larger ABI definition
+// @param `numTypes`      - number of types in the larger ABI definition
+// @param `conditions`    - list of conditions, all of which must be met for a payload to match
+// @param `numConditions` - number of conditions (at most `ABI_PREDICATE_CONDITIONS_MAX`)
+// @return                - true if the predicate was compiled
+bool abi_compile_predicate( ABIPredicate_t * pred,
+                            const ABI_t * types,
+                            size_t numTypes,
+                            const ABICondition_t * conditions,
+                            size_t numConditions);
+
+// Evaluate a compiled predicate against a single payload.
+// @param `pred`      - compiled predicate
+// @param `in`        - Buffer containin the input data
+// @param `inSz`      - Size of `in`
+// @return            - true if the payload matches the predicate
+bool abi_predicate_matches(const ABIPredicate_t * pred, const void * in, size_t inSz);
+
+// Evaluate a compiled predicate against a batch of payloads. Bit `i % 8` of `matches[i / 8]`
+// is set if payload `i` matches. Payloads too short to contain a compared word do not match.
+// @param `matches`   - output bitmap to be written
+// @param `matchesSz` - size of `matches` (at least `(numIns + 7) / 8`)
+// @param `pred`      - compiled predicate
+// @param `ins`       - list of size `numIns` of payloads
+// @param `inSzs`     - list of size `numIns` of payload sizes
+// @param `numIns`    - number of payloads
+// @return            - number of matching payloads; -1 on error.
+int abi_filter_batch( uint8_t * matches,
+                      size_t matchesSz,
+                      const ABIPredicate_t * pred,
+                      const void * const * ins,
+                      const size_t * inSzs,
+                      size_t numIns);
+
+// Aggregations over columns of 256-bit unsigned words (e.g. `uint256` amounts). Words are big endian
+// and may either be read directly out of an ABI payload (e.g. `stride = ABI_WORD_SZ * numParams`
+// to visit one param of a static struct per row) or from decoded `uint256` columns (`stride = ABI_WORD_SZ`).
+
+// Sum a column of words.
+// @param `out`       - 32 byte output buffer for the (big endian) sum
+// @param `words`     - first word of the column
+// @param `stride`    - distance in bytes between the start of consecutive words (at least 32)
+// @param `numWords`  - number of words in the column
+// @return            - 0 on success; -1 on error or if the sum overflows 256 bits.
+int abi_u256_sum(void * out, const void * words, size_t stride, size_t numWords);
+
+// Copy the smallest word of a column into `out` (32 bytes). Params are the same as `abi_u256_sum`.
+// @return            - 0 on success; -1 on error (including an empty column).
+int abi_u256_min(void * out, const void * words, size_t stride, size_t numWords);
+
+// Copy the largest word of a column into `out` (32 bytes). Params are the same as `abi_u256_sum`.
+// @return            - 0 on success; -1 on error (including an empty column).
+int abi_u256_max(void * out, const void * words, size_t stride, size_t numWords);
+
+// Count the words in a column which are strictly greater than a threshold.
+// @param `count`     - number of words greater than `threshold`
+// @param `threshold` - 32 byte big endian threshold
+// Other params are the same as `abi_u256_sum`.
+// @return            - 0 on success; -1 on error.
+int abi_u256_count_gt(size_t * count, const void * words, size_t stride, size_t numWords, const void * threshold);
+
+// Get the zero/nonzero byte counts of a payload (for its intrinsic calldata gas) and its all-zero
+// words and runs of them (for compression) in one pass. Gas is `ABI_CALLDATA_ZERO_BYTE_GAS` per zero byte and `ABI_CALLDATA_NONZERO_BYTE_GAS`
+// per nonzero byte; it does not include the base transaction cost.
+// @param `stats`     - statistics to be written
+// @param `in`        - payload, e.g. calldata including its selector
+// @param `inSz`      - size of `in`
+// @return            - 0 on success; -1 on error
+int abi_calldata_stats(ABICalldataStats_t * stats, const void * in, size_t inSz);
+
+// Select the variant of the vectorized kernels used by every function in this library (e.g. to
+// test or benchmark each variant). The selection is process wide.
+// @param `variant`   - variant to use; `ABI_KERNELS_AUTO` detects the best supported variant again
+// @return            - false if the variant is not supported by this CPU or build (nothing changes)
+bool abi_set_kernels(ABIKernelVariant_t variant);
+
+// Get the variant of the vectorized kernels in use, detecting it if nothing has been decoded yet.
+// @return            - the active variant (never `ABI_KERNELS_AUTO`)
+ABIKernelVariant_t abi_get_kernels(void);
+
 // Encode a payload given a set of types. 
-// All parameter data should be tightly packed in `in`. Numbers are expected to be little endian buffers.
-// NOTE: This has significant limitations at the moment. Tuples and arrays are NOT supported.
+// All parameter data should be tightly packed in `in`, in the same format `abi_decode_param` returns:
+// * Numbers are big endian buffers of up to their type's size (e.g. 1 to 32 bytes for a `uint256`)
+// * `bytesN`, `bytes` and `string` data is unpadded
+// * Arrays of elementary types are their packed elements, each the size `abi_decode_array` writes
+//   (e.g. 20 bytes per `address` or 32 bytes per `uint256`)
+// * Arrays of dynamic types (e.g. `bytes[]` or `string[2]`) are their packed elements, each prefixed
+//   by its size as a 4-byte big endian number
+// * Tuples are their params (in the formats above), each prefixed by its size as a 4-byte big endian
+//   number; arrays of tuples are their tuples, each framed the same way
+// The whole payload is written, including padding, so `out` need not be zeroed.
+// NOTE: Tuples nested inside of tuples are NOT supported.
 // @param `out`       - output buffer to be written
 // @param `outSz`     - size of output buffer to be written
 // @param `types`     - all types in the larger ABI definition
 // @param `numTypes`  - number of types in the larger ABI definition
-// @param `offsets`   - list of size `numTypes` containin offsets for the types' data in `in`
+// @param `offsets`   - list containin offsets for each root param's data in `in` (one per type if
+//                      the schema has no tuples)
 // @param `in`        - Buffer containin the input data
 // @param `inSz`      - Size of `in`
 // @return            - number of bytes written to `out`; -1 on error.
@@ -298,7 +770,256 @@ int abi_encode( void * out,
                 const ABI_t * types, 
                 size_t numTypes, 
                 size_t * offsets, 
-                const void * in, 
+                const void * in,
                 size_t inSz);
 
+// Get the exact number of bytes `abi_encode` would write for a set of params, including the
+// padding of dynamic data, so `out` can be allocated (or a pooled buffer checked) up front.
+// This is one step per param and per array element; elementary values are checked to fit in
+// their types but not copied. Params `abi_encode` would reject are rejected here too.
+// @param `types`     - all types in the larger ABI definition
+// @param `numTypes`  - number of types in the larger ABI definition
+// @param `offsets`   - offsets for each root param's data in `in`, as passed to `abi_encode`
+// @param `in`        - Buffer containin the input data
+// @param `inSz`      - Size of `in`
+// @return            - size of the encoded payload; -1 on error.
+int abi_encoded_size( const ABI_t * types,
+                      size_t numTypes,
+                      size_t * offsets,
+                      const void * in,
+                      size_t inSz);
+
+// Perform `abi_encode` on values described by `ABIValue_t` descriptors rather than packed into one
+// buffer, so each value is copied straight from where it lives into `out`. Elementary values
+// (including array elements) may be shorter than their type, as in `abi_encode`.
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `types`     - all types in the larger ABI definition
+// @param `numTypes`  - number of types in the larger ABI definition
+// @param `values`    - one descriptor per root param (i.e. not for the params nested in tuples)
+// @param `numValues` - number of descriptors in `values`
+// @return            - number of bytes written to `out`; -1 on error.
+int abi_encode_values(void * out,
+                      size_t outSz,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      const ABIValue_t * values,
+                      size_t numValues);
+
+// Perform `abi_encoded_size` on values described by `ABIValue_t` descriptors.
+// @param `types`     - all types in the larger ABI definition
+// @param `numTypes`  - number of types in the larger ABI definition
+// @param `values`    - one descriptor per root param
+// @param `numValues` - number of descriptors in `values`
+// @return            - size of the encoded payload; -1 on error.
+int abi_encoded_values_size(const ABI_t * types,
+                            size_t numTypes,
+                            const ABIValue_t * values,
+                            size_t numValues);
+
+// Get the canonical signature of a function, e.g. `transfer(address,uint256)`, as hashed for its
+// selector. Types are written by their full names (e.g. `uint256` for `ABI_UINT`) and tuples as
+// their params in parentheses.
+// @param `out`       - output buffer for the signature, which is NUL terminated
+// @param `outSz`     - size of `out`
+// @param `name`      - name of the function
+// @param `types`     - all types in the function's ABI definition
+// @param `numTypes`  - number of types in the definition (0 for functions without params)
+// @return            - length of the signature (excluding the NUL); -1 on error.
+int abi_get_signature(char * out, 
+                      size_t outSz, 
+                      const char * name, 
+                      const ABI_t * types, 
+                      size_t numTypes);
+
+// Compile a function schema for `abi_encode_call`, computing its selector from its signature (see
+// `abi_get_signature`). `types` must outlive the function.
+// @param `fn`        - function to be written
+// @param `name`      - name of the function
+// @param `types`     - all types in the function's ABI definition
+// @param `numTypes`  - number of types in the definition (0 for functions without params)
+// @return            - true if the function was compiled
+bool abi_compile_function(ABIFunction_t * fn, const char * name, const ABI_t * types, size_t numTypes);
+
+// Perform `abi_encode` for a call to a compiled function, i.e. write its selector followed by its
+// params in one pass into one buffer.
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `fn`        - function compiled with `abi_compile_function`
+// @param `offsets`   - offsets for each root param's data in `in` (see `abi_encode`)
+// @param `in`        - Buffer containin the input data
+// @param `inSz`      - Size of `in`
+// @return            - number of bytes written to `out` (including the selector); -1 on error.
+int abi_encode_call(void * out, 
+                    size_t outSz, 
+                    const ABIFunction_t * fn, 
+                    size_t * offsets, 
+                    const void * in, 
+                    size_t inSz);
+
+// Perform `abi_encode_values` for a call to a compiled function (see `abi_encode_call`).
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `fn`        - function compiled with `abi_compile_function`
+// @param `values`    - one descriptor per root param
+// @param `numValues` - number of descriptors in `values`
+// @return            - number of bytes written to `out` (including the selector); -1 on error.
+int abi_encode_call_values( void * out, 
+                            size_t outSz, 
+                            const ABIFunction_t * fn, 
+                            const ABIValue_t * values, 
+                            size_t numValues);
+
+// Build a call template for a function which is called many times with only a few params changing.
+// The payload is encoded once, with the constant params and initial values for the variable ones
+// (the slots), and every call is then a copy of it with the slots patched (see `abi_template_encode`).
+// `buf` holds the payload and, like `types`, must outlive the template.
+// @param `tpl`       - template to build
+// @param `buf`       - buffer for the pre-encoded payload
+// @param `bufSz`     - size of `buf`
+// @param `types`     - all types in the larger ABI definition
+// @param `numTypes`  - number of types in the larger ABI definition
+// @param `selector`  - 4-byte function selector to prefix the payload with; NULL for none
+// @param `values`    - one descriptor per root param (see `abi_encode_values`)
+// @param `numValues` - number of descriptors in `values`
+// @param `slotIdxs`  - indices of the root params which vary between calls, in increasing order
+// @param `numSlots`  - number of slots (up to `ABI_TEMPLATE_SLOTS_MAX`)
+// @return            - size of the pre-encoded payload; -1 on error.
+int abi_template_init(ABICallTemplate_t * tpl,
+                      void * buf,
+                      size_t bufSz,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      const uint8_t * selector,
+                      const ABIValue_t * values,
+                      size_t numValues,
+                      const size_t * slotIdxs,
+                      size_t numSlots);
+
+// Encode a call from a template: the template is copied and each slot is written in place. Dynamic
+// slots whose encoded size differs from the template's are re-laid out, i.e. the tail after them
+// is shifted and the offsets which follow them are rewritten.
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `tpl`       - template built with `abi_template_init`
+// @param `slotValues`- one descriptor per slot, in slot order
+// @return            - number of bytes written to `out` (including the selector); -1 on error.
+int abi_template_encode(void * out,
+                        size_t outSz,
+                        const ABICallTemplate_t * tpl,
+                        const ABIValue_t * slotValues);
+
+// Replace one value of an already encoded payload (e.g. to bump a param of a resubmitted call)
+// without decoding and re-encoding it. The value is selected as in `abi_decode_param` and is in the
+// same format it returns. Static values are overwritten in place. If dynamic data (`bytes`, `string`,
+// or an element of an array of them) changes padded size, the data after it is shifted and only the
+// offsets pointing past it are rewritten. Params of tuples cannot be patched.
+// @param `buf`       - encoded params (without the selector), patched in place
+// @param `bufSz`     - size of `buf`, which may be larger than the payload to leave room to grow
+// @param `sz`        - size of the payload in `buf`
+// @param `types`     - array of ABI type definitions
+// @param `numTypes`  - the number of types in this ABI definition
+// @param `info`      - the value to replace
+// @param `val`       - new value
+// @param `valSz`     - size of `val`
+// @return            - new size of the payload; -1 on error.
+int abi_patch_param(void * buf,
+                    size_t bufSz,
+                    size_t sz,
+                    const ABI_t * types,
+                    size_t numTypes,
+                    ABISelector_t info,
+                    const void * val,
+                    size_t valSz);
+
+// Encode values in the non-padded packed layout (Solidity's `abi.encodePacked`), e.g. to hash them
+// for a signature digest or a CREATE2 salt. Elementary values take only their own width (e.g. 2 bytes
+// for an `int16`), `bytes` and `string` are written without a size, and array elements are padded to
+// whole words without a length prefix. Values are given as in `abi_encode_values` and may be shorter
+// than their type. Tuples and arrays of dynamic types have no packed encoding.
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `types`     - array of ABI type definitions
+// @param `numTypes`  - the number of types in this ABI definition
+// @param `values`    - one descriptor per param
+// @param `numValues` - number of descriptors in `values`
+// @return            - number of bytes written to `out`; -1 on error.
+int abi_encode_packed(void * out,
+                      size_t outSz,
+                      const ABI_t * types,
+                      size_t numTypes,
+                      const ABIValue_t * values,
+                      size_t numValues);
+
+// Decode a param of a payload in the packed layout (see `abi_encode_packed`). Packed data has no
+// sizes or offsets, so every param must have a size fixed by the schema except at most one `bytes`,
+// `string` or variable size array, which takes the bytes the others leave. Values are returned in
+// the same format as `abi_decode_param` (e.g. signed integers are sign extended to 32 bytes).
+// @param `out`       - output buffer to be written
+// @param `outSz`     - size of output buffer to be written
+// @param `types`     - array of ABI type definitions
+// @param `numTypes`  - the number of types in this ABI definition
+// @param `info`      - information about the data to be selected
+// @param `in`        - Buffer containing the packed data
+// @param `inSz`      - Size of `in`
+// @return            - number of bytes written to `out`; -1 on error.
+int abi_decode_packed_param(void * out,
+                            size_t outSz,
+                            const ABI_t * types,
+                            size_t numTypes,
+                            ABISelector_t info,
+                            const void * in,
+                            size_t inSz);
+
+// Write a `uintN` (N >= 64 for every value to fit) directly into its 32-byte word, e.g. into an
+// output buffer or into a slot of a payload built with `abi_template_init`.
+// @param `word`      - 32-byte word to be written
+// @param `v`         - value to write (big endian, zero padded)
+void abi_enc_u64(uint8_t * word, uint64_t v);
+
+// Write an `intN` (N >= 64 for every value to fit) directly into its 32-byte word.
+// @param `word`      - 32-byte word to be written
+// @param `v`         - value to write (big endian, padded with 0xff if negative)
+void abi_enc_i64(uint8_t * word, int64_t v);
+
+// Write a `bool` directly into its 32-byte word.
+// @param `word`      - 32-byte word to be written
+// @param `v`         - value to write (as 0 or 1)
+void abi_enc_bool(uint8_t * word, bool v);
+
+// Write an `address` directly into its 32-byte word.
+// @param `word`      - 32-byte word to be written
+// @param `v`         - the 20 address bytes
+void abi_enc_address(uint8_t * word, const uint8_t * v);
+
+// Write a `uint256` directly into its 32-byte word from native 64-bit limbs.
+// @param `word`      - 32-byte word to be written
+// @param `v`         - 4 limbs, least significant first (i.e. `v[0]` holds the low 64 bits)
+void abi_enc_u256_limbs(uint8_t * word, const uint64_t * v);
+
+// Perform `abi_encode` and report the statistics (e.g. intrinsic gas) of the payload it wrote.
+// @param `stats`     - (optional) statistics of the encoded payload (see `abi_calldata_stats`)
+// Other params and the return value are the same as `abi_encode`.
+int abi_encode_with_stats(void * out, 
+                          size_t outSz, 
+                          const ABI_t * types, 
+                          size_t numTypes, 
+                          size_t * offsets, 
+                          const void * in, 
+                          size_t inSz,
+                          ABICalldataStats_t * stats);
+
+// Perform `abi_encode_call` and report the statistics of the calldata it wrote. The byte counts
+// and gas cover the whole call, including the selector, while words are those of the params
+// (i.e. they are aligned to the end of the selector).
+// @param `stats`     - (optional) statistics of the encoded call (see `abi_calldata_stats`)
+// Other params and the return value are the same as `abi_encode_call`.
+int abi_encode_call_with_stats( void * out, 
+                                size_t outSz, 
+                                const ABIFunction_t * fn, 
+                                size_t * offsets, 
+                                const void * in, 
+                                size_t inSz,
+                                ABICalldataStats_t * stats);
+
 #endif
\ No newline at end of file
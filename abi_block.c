@@ -0,0 +1,431 @@
+// Needed for CPU affinity (`pthread_setaffinity_np`)
+#define _GNU_SOURCE
+#include "abi_block.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//===============================================
+// HELPERS
+//===============================================
+// Work assigned to a single decoder thread: a contiguous range of the transactions
+// sorted by schema, along with its share of the output buffers.
+typedef struct {
+  ABIBlockResult_t * results;
+  const ABIBlockTx_t * txs;
+  const ABIBlockSchema_t * schemas;
+  const size_t * order;
+  size_t start;
+  size_t end;
+  uint8_t * out;
+  size_t outSz;
+  ABIItem_t * items;
+  size_t numItems;
+  int numDecoded;
+} ABIBlockWork_t;
+
+static int find_schema(const ABIBlockSchema_t * schemas, size_t numSchemas, const ABIBlockTx_t * tx) {
+  if (!tx->to || !tx->data || tx->dataSz < ABI_SELECTOR_SZ)
+    return -1;
+  for (size_t i = 0; i < numSchemas; i++) {
+    if ((0 == memcmp(schemas[i].selector, tx->data, ABI_SELECTOR_SZ)) &&
+        (0 == memcmp(schemas[i].address, tx->to, ABI_ADDRESS_SZ)))
+      return i;
+  }
+  return -1;
+}
+
+// Decode a range of transactions which are sorted by schema. Each run of transactions
+// calling the same schema is decoded in batches of up to `BLOCK_BATCH_SZ` payloads.
+#define BLOCK_BATCH_SZ 64
+
+static void * decode_range(void * arg) {
+  ABIBlockWork_t * w = arg;
+  size_t outOff = 0;
+  size_t itemOff = 0;
+  size_t i = w->start;
+  while (i < w->end) {
+    int schemaIdx = w->results[w->order[i]].schemaIdx;
+    const ABIBlockSchema_t * schema = &w->schemas[schemaIdx];
+    const void * ins[BLOCK_BATCH_SZ];
+    size_t inSzs[BLOCK_BATCH_SZ];
+    int counts[BLOCK_BATCH_SZ];
+    size_t batchSz = 0;
+    while ((i + batchSz < w->end) && 
+           (batchSz < BLOCK_BATCH_SZ) &&
+           (w->results[w->order[i + batchSz]].schemaIdx == schemaIdx)) {
+      const ABIBlockTx_t * tx = &w->txs[w->order[i + batchSz]];
+      ins[batchSz] = tx->data + ABI_SELECTOR_SZ;
+      inSzs[batchSz] = tx->dataSz - ABI_SELECTOR_SZ;
+      batchSz++;
+    }
+    // Items written by this batch reference data relative to the batch's output buffer
+    uint8_t * batchOut = w->out + outOff;
+    ABIItem_t * batchItems = w->items + itemOff;
+    int n = abi_decode_batch( batchOut, w->outSz - outOff, batchItems, w->numItems - itemOff,
+                              schema->types, schema->numTypes, schema->projection,
+                              ins, inSzs, batchSz, counts, schema->flags);
+    size_t batchOutSz = 0;
+    size_t k = 0;
+    for (size_t j = 0; j < batchSz; j++) {
+      ABIBlockResult_t * r = &w->results[w->order[i + j]];
+      r->numItems = (n < 0) ? -1 : counts[j];
+      if (r->numItems < 0)
+        continue;
+      r->items = batchItems + k;
+      r->out = batchOut;
+      for (int m = 0; m < r->numItems; m++, k++) {
+        batchItems[k].payloadIdx = w->order[i + j];
+        batchOutSz = batchItems[k].off + batchItems[k].sz;
+      }
+      w->numDecoded++;
+    }
+    outOff += batchOutSz;
+    itemOff += k;
+    i += batchSz;
+  }
+  return NULL;
+}
+
+// Match each transaction to a schema and sort the matched transactions by schema.
+// This is a counting sort, so transactions in each group stay in block order.
+// `order` must have room for `numTxs` indices and `groupStart` for `numSchemas + 1`.
+// Returns the number of matched transactions, which are written to the front of `order`.
+static size_t group_by_schema(ABIBlockResult_t * results,
+                              const ABIBlockTx_t * txs,
+                              size_t numTxs,
+                              const ABIBlockSchema_t * schemas,
+                              size_t numSchemas,
+                              size_t * order,
+                              size_t * groupStart)
+{
+  memset(groupStart, 0, (numSchemas + 1) * sizeof(size_t));
+  for (size_t i = 0; i < numTxs; i++) {
+    results[i] = (ABIBlockResult_t) { .schemaIdx = find_schema(schemas, numSchemas, &txs[i]), .numItems = -1 };
+    if (results[i].schemaIdx >= 0)
+      groupStart[results[i].schemaIdx + 1]++;
+  }
+  for (size_t i = 0; i < numSchemas; i++)
+    groupStart[i + 1] += groupStart[i];
+  size_t numMatched = groupStart[numSchemas];
+  for (size_t i = 0; i < numTxs; i++)
+    if (results[i].schemaIdx >= 0)
+      order[groupStart[results[i].schemaIdx]++] = i;
+  return numMatched;
+}
+
+// Get the range of sorted transactions assigned to thread `t` of `numThreads`
+static void get_thread_range(size_t numMatched, size_t numThreads, size_t t, size_t * start, size_t * end) {
+  size_t perThread = (numMatched + numThreads - 1) / numThreads;
+  *start = t * perThread < numMatched ? t * perThread : numMatched;
+  *end = (t + 1) * perThread < numMatched ? (t + 1) * perThread : numMatched;
+}
+
+// A bump allocator over a fixed buffer. Everything allocated from it is released
+// at once by resetting it.
+typedef struct {
+  uint8_t * base;
+  size_t sz;
+  size_t used;
+} ABIArena_t;
+
+static void * arena_alloc(ABIArena_t * a, size_t sz, size_t align) {
+  size_t start = (a->used + align - 1) & ~(align - 1);
+  if (start > a->sz || sz > a->sz - start)
+    return NULL;
+  a->used = start + sz;
+  return a->base + start;
+}
+
+// Allocate a buffer and touch every page so it is backed by memory local to the calling thread
+static void * alloc_local(size_t sz) {
+  void * p = malloc(sz > 0 ? sz : 1);
+  if (p)
+    memset(p, 0, sz);
+  return p;
+}
+
+static bool arena_init(ABIArena_t * a, size_t sz) {
+  a->base = alloc_local(sz);
+  a->sz = sz;
+  a->used = 0;
+  return (a->base != NULL);
+}
+
+#define CACHE_LINE_SZ 64
+
+// Each worker is padded to its own cache lines so that workers publishing their
+// results do not contend with one another.
+typedef struct {
+  ABIBlockPool_t * pool;
+  size_t idx;
+  pthread_t thread;
+  uint8_t * values;                   // Decoded data
+  ABIItem_t * items;                  // Decoded items
+  ABIBlockWork_t work;
+} __attribute__((aligned(CACHE_LINE_SZ))) ABIBlockWorker_t;
+
+struct ABIBlockPool {
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  size_t generation;                  // Incremented for every batch of work
+  size_t numPending;                  // Workers which have not finished the current batch
+  size_t numReady;                    // Workers which have set up their buffers
+  size_t numPinned;                   // Workers which were pinned to a CPU
+  bool failed;                        // A worker could not set up its buffers
+  bool stop;
+  size_t valuesSz;
+  size_t indicesSz;
+  ABIArena_t scratch;                 // Grouping indices (used by the submitting thread)
+  size_t maxTxs;                      // Most transactions the scratch arena has room for
+  size_t maxSchemas;                  // Most schemas the scratch arena has room for
+  size_t numWorkers;
+  ABIBlockWorker_t * workers;
+};
+
+// Get the number of CPUs this process may run on
+static size_t get_num_cpus(void) {
+#ifdef __linux__
+  cpu_set_t allowed;
+  if (0 == sched_getaffinity(0, sizeof(allowed), &allowed) && CPU_COUNT(&allowed) > 0)
+    return CPU_COUNT(&allowed);
+#endif
+  long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return numCpus > 0 ? numCpus : 1;
+}
+
+// Pin the calling thread to the `idx`th CPU (wrapping around) of those this process may run on,
+// which need not be contiguous. Returns false if the thread could not be pinned.
+static bool pin_to_cpu(size_t idx) {
+#ifdef __linux__
+  cpu_set_t allowed;
+  if (0 != sched_getaffinity(0, sizeof(allowed), &allowed) || CPU_COUNT(&allowed) <= 0)
+    return false;
+  size_t target = idx % CPU_COUNT(&allowed);
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &allowed) || target-- > 0)
+      continue;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return (0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set));
+  }
+  return false;
+#else
+  (void) idx;
+  return false;
+#endif
+}
+
+static void * worker_main(void * arg) {
+  ABIBlockWorker_t * w = arg;
+  ABIBlockPool_t * pool = w->pool;
+  // Pin before allocating so the buffers are faulted in on this worker's core
+  bool pinned = pin_to_cpu(w->idx);
+  w->values = alloc_local(pool->valuesSz);
+  w->items = alloc_local(pool->indicesSz);
+  bool ok = (w->values && w->items);
+  pthread_mutex_lock(&pool->lock);
+  pool->numReady++;
+  if (pinned)
+    pool->numPinned++;
+  if (!ok)
+    pool->failed = true;
+  pthread_cond_broadcast(&pool->done);
+  size_t generation = pool->generation;
+  while (true) {
+    while (!pool->stop && pool->generation == generation)
+      pthread_cond_wait(&pool->start, &pool->lock);
+    if (pool->stop)
+      break;
+    generation = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+    decode_range(&w->work);
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->numPending == 0)
+      pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+//===============================================
+// API
+//===============================================
+int abi_decode_block( ABIBlockResult_t * results,
+                      const ABIBlockTx_t * txs,
+                      size_t numTxs,
+                      const ABIBlockSchema_t * schemas,
+                      size_t numSchemas,
+                      uint8_t * out,
+                      size_t outSz,
+                      ABIItem_t * items,
+                      size_t numItems,
+                      size_t numThreads)
+{
+  if (!results || !txs || !schemas || !out || !items)
+    return -1;
+  // The per-thread state lives on the stack, so the number of threads is capped
+  if (numThreads == 0)
+    numThreads = 1;
+  else if (numThreads > ABI_BLOCK_THREADS_MAX)
+    numThreads = ABI_BLOCK_THREADS_MAX;
+  // Match each transaction to a schema and sort the matched ones by schema
+  size_t * groupStart = malloc((numSchemas + 1) * sizeof(size_t));
+  size_t * order = malloc((numTxs + 1) * sizeof(size_t));
+  if (!groupStart || !order) {
+    free(groupStart);
+    free(order);
+    return -1;
+  }
+  size_t numMatched = group_by_schema(results, txs, numTxs, schemas, numSchemas, order, groupStart);
+  free(groupStart);
+
+  // Split the sorted transactions and the output buffers between threads
+  if (numThreads > numMatched)
+    numThreads = numMatched > 0 ? numMatched : 1;
+  ABIBlockWork_t work[numThreads];
+  pthread_t threads[numThreads];
+  for (size_t t = 0; t < numThreads; t++) {
+    work[t] = (ABIBlockWork_t) {
+      .results = results, .txs = txs, .schemas = schemas, .order = order,
+      .out = out + (t * (outSz / numThreads)), .outSz = outSz / numThreads,
+      .items = items + (t * (numItems / numThreads)), .numItems = numItems / numThreads,
+    };
+    get_thread_range(numMatched, numThreads, t, &work[t].start, &work[t].end);
+  }
+  bool spawned[numThreads];
+  for (size_t t = 1; t < numThreads; t++)
+    spawned[t] = (0 == pthread_create(&threads[t], NULL, decode_range, &work[t]));
+  // The calling thread decodes the first range
+  decode_range(&work[0]);
+  int numDecoded = work[0].numDecoded;
+  for (size_t t = 1; t < numThreads; t++) {
+    if (spawned[t])
+      pthread_join(threads[t], NULL);
+    else
+      decode_range(&work[t]);
+    numDecoded += work[t].numDecoded;
+  }
+  free(order);
+  return numDecoded;
+}
+
+ABIBlockPool_t * abi_block_pool_create(size_t numWorkers, 
+                                        size_t valuesSz, 
+                                        size_t indicesSz, 
+                                        size_t maxTxs, 
+                                        size_t maxSchemas) 
+{
+  if (numWorkers == 0)
+    numWorkers = get_num_cpus();
+  ABIBlockPool_t * pool = calloc(1, sizeof(ABIBlockPool_t));
+  if (!pool)
+    return NULL;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  pool->valuesSz = valuesSz;
+  pool->indicesSz = indicesSz;
+  // Room for the sorted transaction indices and the group counts of the schemas
+  pool->maxTxs = maxTxs;
+  pool->maxSchemas = maxSchemas;
+  if (numWorkers > SIZE_MAX / sizeof(ABIBlockWorker_t) ||
+      maxSchemas > (SIZE_MAX / sizeof(size_t)) - 2 ||
+      maxTxs > (SIZE_MAX / sizeof(size_t)) - maxSchemas - 2 ||
+      0 != posix_memalign((void **) &pool->workers, CACHE_LINE_SZ, numWorkers * sizeof(ABIBlockWorker_t)) ||
+      !arena_init(&pool->scratch, (maxTxs + maxSchemas + 1) * sizeof(size_t))) {
+    abi_block_pool_destroy(pool);
+    return NULL;
+  }
+  memset(pool->workers, 0, numWorkers * sizeof(ABIBlockWorker_t));
+  for (size_t i = 0; i < numWorkers; i++) {
+    ABIBlockWorker_t * w = &pool->workers[i];
+    w->pool = pool;
+    w->idx = i;
+    if (0 != pthread_create(&w->thread, NULL, worker_main, w)) {
+      abi_block_pool_destroy(pool);
+      return NULL;
+    }
+    pool->numWorkers++;
+  }
+  // Wait for every worker to set up its buffers
+  pthread_mutex_lock(&pool->lock);
+  while (pool->numReady < pool->numWorkers)
+    pthread_cond_wait(&pool->done, &pool->lock);
+  bool failed = pool->failed;
+  pthread_mutex_unlock(&pool->lock);
+  if (failed) {
+    abi_block_pool_destroy(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+size_t abi_block_pool_num_pinned(const ABIBlockPool_t * pool) {
+  return pool ? pool->numPinned : 0;
+}
+
+void abi_block_pool_destroy(ABIBlockPool_t * pool) {
+  if (!pool)
+    return;
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+  for (size_t i = 0; i < pool->numWorkers; i++) {
+    pthread_join(pool->workers[i].thread, NULL);
+    free(pool->workers[i].values);
+    free(pool->workers[i].items);
+  }
+  free(pool->workers);
+  free(pool->scratch.base);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool);
+}
+
+int abi_block_pool_decode(ABIBlockPool_t * pool,
+                          ABIBlockResult_t * results,
+                          const ABIBlockTx_t * txs,
+                          size_t numTxs,
+                          const ABIBlockSchema_t * schemas,
+                          size_t numSchemas)
+{
+  if (!pool || !results || !txs || !schemas || numTxs > pool->maxTxs || numSchemas > pool->maxSchemas)
+    return -1;
+  // Recycle the scratch arena and the workers' buffers used by the previous batch
+  pool->scratch.used = 0;
+  size_t * order = arena_alloc(&pool->scratch, numTxs * sizeof(size_t), sizeof(size_t));
+  size_t * groupStart = arena_alloc(&pool->scratch, (numSchemas + 1) * sizeof(size_t), sizeof(size_t));
+  if (!order || !groupStart)
+    return -1;
+  size_t numMatched = group_by_schema(results, txs, numTxs, schemas, numSchemas, order, groupStart);
+  for (size_t t = 0; t < pool->numWorkers; t++) {
+    ABIBlockWorker_t * w = &pool->workers[t];
+    w->work = (ABIBlockWork_t) {
+      .results = results, .txs = txs, .schemas = schemas, .order = order,
+      .out = w->values, .outSz = pool->valuesSz,
+      .items = w->items, .numItems = pool->indicesSz / sizeof(ABIItem_t),
+    };
+    get_thread_range(numMatched, pool->numWorkers, t, &w->work.start, &w->work.end);
+  }
+  // Hand the ranges to the workers and wait for all of them to finish
+  pthread_mutex_lock(&pool->lock);
+  pool->numPending = pool->numWorkers;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  while (pool->numPending > 0)
+    pthread_cond_wait(&pool->done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+  int numDecoded = 0;
+  for (size_t t = 0; t < pool->numWorkers; t++)
+    numDecoded += pool->workers[t].work.numDecoded;
+  return numDecoded;
+}
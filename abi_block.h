@@ -0,0 +1,118 @@
+/**
+ * Ethereum ABI block decoder
+ * https://github.com/GridPlus/ethereum-abi-c
+ * 
+ * Decodes all of the contract calls in a block in parallel, dispatching each
+ * transaction to a known schema by its destination address and 4-byte selector.
+ * This is built on top of the batch decoder in `abi.h` and requires pthreads.
+ *
+ * MIT License (see abi.h)
+ */
+
+#ifndef __ETHEREUM_ABI_BLOCK_H_
+#define __ETHEREUM_ABI_BLOCK_H_
+
+#include "abi.h"
+
+// Most threads `abi_decode_block` will decode with
+#define ABI_BLOCK_THREADS_MAX 64
+
+// A function we know how to decode. Transactions are matched to it by the contract
+// address they are sent to and the selector prefixing their calldata.
+typedef struct {
+  uint8_t address[ABI_ADDRESS_SZ];    // Contract address
+  uint8_t selector[ABI_SELECTOR_SZ];  // Function selector
+  const ABI_t * types;                // Schema of the function params
+  size_t numTypes;                    // Number of types in the schema
+  const bool * projection;            // (optional) projection mask over `types` (see `abi_decode_walk`)
+  uint32_t flags;                     // `ABIDecodeFlags_t` options for decoding this function
+} ABIBlockSchema_t;
+
+// A transaction in a block. `data` is the full calldata, i.e. it includes the selector.
+typedef struct {
+  const uint8_t * to;                 // Destination address (20 bytes)
+  const uint8_t * data;               // Calldata
+  size_t dataSz;                      // Size of `data`
+} ABIBlockTx_t;
+
+// Decoding result for a single transaction
+typedef struct {
+  int schemaIdx;                      // Index of the matching schema; -1 if no schema matched
+  int numItems;                       // Number of decoded items; -1 if the calldata could not be decoded
+  const ABIItem_t * items;            // Decoded items (`payloadIdx` is the transaction index)
+  const uint8_t * out;                // Buffer containing the decoded data of `items`
+} ABIBlockResult_t;
+
+// Decode every transaction in a block which calls one of the known schemas.
+// Transactions are grouped by schema so each group is decoded back to back, and the groups
+// are split across `numThreads` threads. Results are written in the original transaction order.
+// The output buffers are split evenly between threads, so they should be sized with some headroom.
+// @param `results`    - list of size `numTxs` of results to be written
+// @param `txs`        - list of transactions in the block
+// @param `numTxs`     - number of transactions
+// @param `schemas`    - list of known schemas
+// @param `numSchemas` - number of known schemas
+// @param `out`        - output buffer for decoded data
+// @param `outSz`      - size of `out`
+// @param `items`      - output buffer for decoded items
+// @param `numItems`   - capacity of `items`
+// @param `numThreads` - number of threads to decode with (at most `ABI_BLOCK_THREADS_MAX`)
+// @return             - number of transactions successfully decoded; -1 on error.
+int abi_decode_block( ABIBlockResult_t * results,
+                      const ABIBlockTx_t * txs,
+                      size_t numTxs,
+                      const ABIBlockSchema_t * schemas,
+                      size_t numSchemas,
+                      uint8_t * out,
+                      size_t outSz,
+                      ABIItem_t * items,
+                      size_t numItems,
+                      size_t numThreads);
+
+// A pool of decoder threads for repeatedly decoding blocks. Each worker is pinned to a core and
+// owns private buffers for decoded data and items, which are allocated (and faulted in) by the
+// worker itself and are reused for every block. Nothing is allocated while decoding.
+typedef struct ABIBlockPool ABIBlockPool_t;
+
+// Create a worker pool. Workers are spread over the CPUs this process may run on (i.e. its
+// affinity mask); see `abi_block_pool_num_pinned` for whether they could be pinned.
+// @param `numWorkers` - number of worker threads (0 uses one per CPU this process may run on)
+// @param `valuesSz`   - size of each worker's buffer for decoded data
+// @param `indicesSz`  - size of each worker's buffer for decoded items
+// @param `maxTxs`     - largest number of transactions that will be decoded at once
+// @param `maxSchemas` - largest number of schemas that will be passed to `abi_block_pool_decode`
+// @return             - the pool; NULL on error.
+ABIBlockPool_t * abi_block_pool_create(size_t numWorkers, 
+                                        size_t valuesSz, 
+                                        size_t indicesSz, 
+                                        size_t maxTxs, 
+                                        size_t maxSchemas);
+
+// Get the number of workers which were pinned to a CPU. Workers which could not be pinned
+// (e.g. if the platform does not support it) still decode, but may migrate between CPUs.
+// @param `pool`       - worker pool
+// @return             - number of pinned workers
+size_t abi_block_pool_num_pinned(const ABIBlockPool_t * pool);
+
+// Stop all workers and release the pool.
+void abi_block_pool_destroy(ABIBlockPool_t * pool);
+
+// Perform `abi_decode_block` using a worker pool. Decoded data and items live in the workers'
+// buffers, so results are only valid until the next call with the same pool.
+// Calls with the same pool must not be made concurrently, and fail if they pass more transactions
+// or schemas than the pool was created for.
+// @param `pool`       - worker pool
+// @param `results`    - list of size `numTxs` of results to be written
+// @param `txs`        - list of transactions in the block
+// @param `numTxs`     - number of transactions
+// @param `schemas`    - list of known schemas
+// @param `numSchemas` - number of known schemas
+// @return             - number of transactions successfully decoded; -1 on error.
+int abi_block_pool_decode(ABIBlockPool_t * pool,
+                          ABIBlockResult_t * results,
+                          const ABIBlockTx_t * txs,
+                          size_t numTxs,
+                          const ABIBlockSchema_t * schemas,
+                          size_t numSchemas);
+
+#endif
@@ -0,0 +1,341 @@
+#include "abi.h"
+#include "abi_block.h"
+#include "test_vec.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#define ARRAY_SIZE(a) sizeof(a)/sizeof(a[0])
+
+//===============================================================
+// BENCHMARKS
+//===============================================================
+// Throughput benchmarks over a synthetic block. Every transaction in the block calls
+// one of a handful of functions from `test_vec.h` (or an unknown one).
+
+#define BLOCK_NUM_TXS 500
+#define BLOCK_ITERS 200
+#define BENCH_OUT_SZ (4 * 1024 * 1024)
+#define BENCH_NUM_ITEMS (BLOCK_NUM_TXS * 128)
+
+typedef struct {
+  const ABI_t * types;
+  size_t numTypes;
+  uint8_t * encoded;
+  size_t encodedSz;
+} BenchFn_t;
+
+static BenchFn_t fns[] = {
+  { fillOrder_abi, ARRAY_SIZE(fillOrder_abi), fillOrder_encoded, sizeof(fillOrder_encoded) },
+  { marketSellOrders_abi, ARRAY_SIZE(marketSellOrders_abi), marketSellOrders_encoded, sizeof(marketSellOrders_encoded) },
+  { ex1_abi, ARRAY_SIZE(ex1_abi), ex1_encoded, sizeof(ex1_encoded) },
+  { ex3_abi, ARRAY_SIZE(ex3_abi), ex3_encoded, sizeof(ex3_encoded) },
+  { ex4_abi, ARRAY_SIZE(ex4_abi), ex4_encoded, sizeof(ex4_encoded) },
+  { ex5_abi, ARRAY_SIZE(ex5_abi), ex5_encoded, sizeof(ex5_encoded) },
+};
+
+static uint8_t addresses[ARRAY_SIZE(fns) + 1][ABI_ADDRESS_SZ];
+static ABIBlockSchema_t schemas[ARRAY_SIZE(fns)];
+static ABIBlockTx_t txs[BLOCK_NUM_TXS];
+static ABIBlockResult_t results[BLOCK_NUM_TXS];
+static uint8_t out[BENCH_OUT_SZ];
+static ABIItem_t items[BENCH_NUM_ITEMS];
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void build_block(void) {
+  for (size_t i = 0; i < ARRAY_SIZE(addresses); i++)
+    memset(addresses[i], (int) (i + 1), ABI_ADDRESS_SZ);
+  for (size_t i = 0; i < ARRAY_SIZE(fns); i++) {
+    schemas[i].types = fns[i].types;
+    schemas[i].numTypes = fns[i].numTypes;
+    memcpy(schemas[i].address, addresses[i], ABI_ADDRESS_SZ);
+    memcpy(schemas[i].selector, fns[i].encoded, ABI_SELECTOR_SZ);
+  }
+  // Interleave the functions so consecutive transactions rarely share a schema.
+  // Every 10th transaction calls a contract we do not know about.
+  uint32_t seed = 1;
+  for (size_t i = 0; i < BLOCK_NUM_TXS; i++) {
+    seed = seed * 1103515245 + 12345;
+    size_t fn = (seed >> 16) % ARRAY_SIZE(fns);
+    txs[i].to = (i % 10 == 9) ? addresses[ARRAY_SIZE(fns)] : addresses[fn];
+    txs[i].data = fns[fn].encoded;
+    txs[i].dataSz = fns[fn].encodedSz;
+  }
+}
+
+// Baseline: decode each transaction on its own, in block order, on a single thread
+static double bench_sequential(uint32_t flags) {
+  double start = now();
+  for (size_t iter = 0; iter < BLOCK_ITERS; iter++) {
+    for (size_t i = 0; i < BLOCK_NUM_TXS; i++) {
+      if (txs[i].to == addresses[ARRAY_SIZE(fns)])
+        continue;
+      size_t fn = 0;
+      while (fns[fn].encoded != txs[i].data)
+        fn++;
+      int n = abi_decode_walk(out, BENCH_OUT_SZ, items, BENCH_NUM_ITEMS, fns[fn].types, fns[fn].numTypes, 
+                              NULL, txs[i].data + ABI_SELECTOR_SZ, txs[i].dataSz - ABI_SELECTOR_SZ, flags);
+      assert(n > 0);
+    }
+  }
+  return (BLOCK_ITERS * BLOCK_NUM_TXS) / (now() - start);
+}
+
+static double bench_block(size_t numThreads) {
+  double start = now();
+  for (size_t iter = 0; iter < BLOCK_ITERS; iter++) {
+    int n = abi_decode_block( results, txs, BLOCK_NUM_TXS, schemas, ARRAY_SIZE(schemas), 
+                              out, BENCH_OUT_SZ, items, BENCH_NUM_ITEMS, numThreads);
+    assert(n == BLOCK_NUM_TXS - (BLOCK_NUM_TXS / 10));
+  }
+  return (BLOCK_ITERS * BLOCK_NUM_TXS) / (now() - start);
+}
+
+// Front end filter: match every transaction's selector against the known functions
+static double bench_match_selectors(void) {
+  static const void * ins[BLOCK_NUM_TXS];
+  static size_t inSzs[BLOCK_NUM_TXS];
+  static int matches[BLOCK_NUM_TXS];
+  uint8_t selectors[ARRAY_SIZE(fns) * ABI_SELECTOR_SZ];
+  for (size_t i = 0; i < ARRAY_SIZE(fns); i++)
+    memcpy(selectors + (i * ABI_SELECTOR_SZ), fns[i].encoded, ABI_SELECTOR_SZ);
+  for (size_t i = 0; i < BLOCK_NUM_TXS; i++) {
+    ins[i] = txs[i].data;
+    inSzs[i] = txs[i].dataSz;
+  }
+  double start = now();
+  for (size_t iter = 0; iter < BLOCK_ITERS * 100; iter++) {
+    int n = abi_match_selectors(matches, ins, inSzs, BLOCK_NUM_TXS, selectors, ARRAY_SIZE(fns));
+    assert(n > 0);
+  }
+  return ((double) BLOCK_ITERS * 100 * BLOCK_NUM_TXS) / (now() - start);
+}
+
+static double bench_pool(size_t numWorkers) {
+  ABIBlockPool_t * pool = abi_block_pool_create(numWorkers, BENCH_OUT_SZ, BENCH_NUM_ITEMS * sizeof(ABIItem_t), 
+                                                BLOCK_NUM_TXS, ARRAY_SIZE(schemas));
+  assert(pool);
+  double start = now();
+  for (size_t iter = 0; iter < BLOCK_ITERS; iter++) {
+    int n = abi_block_pool_decode(pool, results, txs, BLOCK_NUM_TXS, schemas, ARRAY_SIZE(schemas));
+    assert(n == BLOCK_NUM_TXS - (BLOCK_NUM_TXS / 10));
+  }
+  double rate = (BLOCK_ITERS * BLOCK_NUM_TXS) / (now() - start);
+  abi_block_pool_destroy(pool);
+  return rate;
+}
+
+// An `address[]` payload, e.g. a token allowlist or airdrop recipients
+#define ARRAY_NUM_ELEMS 10000
+#define ARRAY_ITERS 200
+
+static ABI_t addressArray_abi[1] = { { .type = ABI_ADDRESS, .isArray = true } };
+// The same payload, read as a `uint256[]`
+static ABI_t uintArray_abi[1] = { { .type = ABI_UINT256, .isArray = true } };
+static uint8_t addressArray[ABI_WORD_SZ * (2 + ARRAY_NUM_ELEMS)];
+
+static void build_address_array(void) {
+  addressArray[ABI_WORD_SZ - 1] = ABI_WORD_SZ;
+  addressArray[(2 * ABI_WORD_SZ) - 2] = (ARRAY_NUM_ELEMS >> 8) & 0xff;
+  addressArray[(2 * ABI_WORD_SZ) - 1] = ARRAY_NUM_ELEMS & 0xff;
+  for (size_t i = 0; i < ARRAY_NUM_ELEMS; i++)
+    for (size_t j = 12; j < ABI_WORD_SZ; j++)
+      addressArray[(2 + i) * ABI_WORD_SZ + j] = (uint8_t) (i + j);
+}
+
+// Baseline: decode each element on its own
+static double bench_array_elems(void) {
+  double start = now();
+  for (size_t iter = 0; iter < ARRAY_ITERS; iter++) {
+    for (size_t i = 0; i < ARRAY_NUM_ELEMS; i++) {
+      ABISelector_t info = { .typeIdx = 0, .arrIdx = i };
+      int n = abi_decode_param( out + (20 * i), BENCH_OUT_SZ - (20 * i), addressArray_abi, 1, info, 
+                                addressArray, sizeof(addressArray));
+      assert(n == 20);
+    }
+  }
+  return (ARRAY_ITERS * ARRAY_NUM_ELEMS) / (now() - start);
+}
+
+static double bench_array_bulk(const ABI_t * types, uint32_t flags) {
+  ABISelector_t info = { .typeIdx = 0 };
+  double start = now();
+  for (size_t iter = 0; iter < ARRAY_ITERS; iter++) {
+    int n = abi_decode_array(out, BENCH_OUT_SZ, types, 1, info, addressArray, sizeof(addressArray), flags);
+    assert(n == ARRAY_NUM_ELEMS);
+  }
+  return (ARRAY_ITERS * ARRAY_NUM_ELEMS) / (now() - start);
+}
+
+// Re-encode the decoded addresses as an `address[]` payload
+static double bench_array_encode(void) {
+  ABISelector_t info = { .typeIdx = 0 };
+  static uint8_t addrs[ARRAY_NUM_ELEMS * 20];
+  int n = abi_decode_array(addrs, sizeof(addrs), addressArray_abi, 1, info, addressArray, sizeof(addressArray), 0);
+  assert(n == ARRAY_NUM_ELEMS);
+  size_t offsets[1] = { 0 };
+  double start = now();
+  for (size_t iter = 0; iter < ARRAY_ITERS; iter++) {
+    n = abi_encode(out, BENCH_OUT_SZ, addressArray_abi, 1, offsets, addrs, sizeof(addrs));
+    assert(n == (int) sizeof(addressArray));
+  }
+  assert(0 == memcmp(out, addressArray, sizeof(addressArray)));
+  return (ARRAY_ITERS * ARRAY_NUM_ELEMS) / (now() - start);
+}
+
+// Same as above, but each address is read in place (from its word in the source payload)
+// through a descriptor instead of being staged into a packed buffer
+static double bench_array_encode_values(void) {
+  static ABIValue_t elems[ARRAY_NUM_ELEMS];
+  for (size_t i = 0; i < ARRAY_NUM_ELEMS; i++) {
+    elems[i].ptr = addressArray + (ABI_WORD_SZ * (2 + i)) + 12;
+    elems[i].len = 20;
+  }
+  ABIValue_t value = { elems, ARRAY_NUM_ELEMS };
+  int n = 0;
+  double start = now();
+  for (size_t iter = 0; iter < ARRAY_ITERS; iter++) {
+    n = abi_encode_values(out, BENCH_OUT_SZ, addressArray_abi, 1, &value, 1);
+    assert(n == (int) sizeof(addressArray));
+  }
+  assert(0 == memcmp(out, addressArray, sizeof(addressArray)));
+  return (ARRAY_ITERS * ARRAY_NUM_ELEMS) / (now() - start);
+}
+
+// Hex calldata, as it arrives from JSON-RPC
+#define HEX_SZ (64 * 1024)
+#define HEX_ITERS 2000
+
+static char hex[2 + (2 * HEX_SZ)];
+
+static double bench_hex_decode(void) {
+  const char * digits = "0123456789abcdef";
+  hex[0] = '0';
+  hex[1] = 'x';
+  for (size_t i = 2; i < sizeof(hex); i++)
+    hex[i] = digits[(i * 7) % 16];
+  double start = now();
+  for (size_t iter = 0; iter < HEX_ITERS; iter++) {
+    int n = abi_hex_decode(out, BENCH_OUT_SZ, hex, sizeof(hex));
+    assert(n == HEX_SZ);
+  }
+  return ((double) HEX_ITERS * HEX_SZ) / (now() - start) / (1024 * 1024);
+}
+
+static double bench_hex_encode(void) {
+  double start = now();
+  for (size_t iter = 0; iter < HEX_ITERS; iter++) {
+    int n = abi_hex_encode(hex, sizeof(hex), addressArray, HEX_SZ);
+    assert(n == (int) sizeof(hex));
+  }
+  return ((double) HEX_ITERS * HEX_SZ) / (now() - start) / (1024 * 1024);
+}
+
+// Intrinsic gas and zero runs of the `address[]` payload
+static double bench_calldata_stats(void) {
+  ABICalldataStats_t stats;
+  double start = now();
+  for (size_t iter = 0; iter < HEX_ITERS; iter++) {
+    int n = abi_calldata_stats(&stats, addressArray, sizeof(addressArray));
+    assert(n == 0 && stats.zeroBytes > 0);
+  }
+  return ((double) HEX_ITERS * sizeof(addressArray)) / (now() - start) / (1024 * 1024);
+}
+
+// Addresses from the `address[]` payload, decoded and converted to hex strings
+static char addressHex[ARRAY_NUM_ELEMS * 42];
+
+static double bench_address_hex(uint32_t flags) {
+  ABISelector_t info = { .typeIdx = 0 };
+  int n = abi_decode_array(out, BENCH_OUT_SZ, addressArray_abi, 1, info, addressArray, sizeof(addressArray), 0);
+  assert(n == ARRAY_NUM_ELEMS);
+  double start = now();
+  for (size_t iter = 0; iter < ARRAY_ITERS; iter++) {
+    n = abi_hex_encode_column(addressHex, sizeof(addressHex), out, ABI_ADDRESS_SZ, ARRAY_NUM_ELEMS, flags);
+    assert(n == (int) sizeof(addressHex));
+  }
+  return (ARRAY_ITERS * ARRAY_NUM_ELEMS) / (now() - start);
+}
+
+// fillOrder calls where only the amount changes, encoded from scratch or patched into a template
+#define CALL_ITERS 100000
+
+static double bench_fill_order(bool useTemplate) {
+  const uint8_t * order[12] = { fillOrder_p0_t0, fillOrder_p0_t1, fillOrder_p0_t2, fillOrder_p0_t3, 
+                                fillOrder_p0_t4, fillOrder_p0_t5, fillOrder_p0_t6, fillOrder_p0_t7, 
+                                fillOrder_p0_t8, fillOrder_p0_t9, fillOrder_p0_t10, fillOrder_p0_t11 };
+  const size_t orderSzs[12] = { 20, 20, 20, 20, 32, 32, 32, 32, 32, 32, 36, 36 };
+  ABIValue_t orderParams[12];
+  for (size_t i = 0; i < 12; i++) {
+    orderParams[i].ptr = order[i];
+    orderParams[i].len = orderSzs[i];
+  }
+  uint8_t amount[8] = { 0 };
+  ABIValue_t values[3] = {  { orderParams, 12 }, 
+                            { amount, sizeof(amount) }, 
+                            { fillOrder_p2_0, sizeof(fillOrder_p2_0) } };
+  static uint8_t tplBuf[1024];
+  ABICallTemplate_t tpl;
+  size_t slotIdx = 1;
+  int n = abi_template_init(&tpl, tplBuf, sizeof(tplBuf), fillOrder_abi, ARRAY_SIZE(fillOrder_abi), 
+                            fillOrder_encoded, values, 3, &slotIdx, 1);
+  assert(n == (int) sizeof(fillOrder_encoded));
+  double start = now();
+  for (size_t iter = 0; iter < CALL_ITERS; iter++) {
+    amount[7] = (uint8_t) iter;
+    if (useTemplate) {
+      n = abi_template_encode(out, BENCH_OUT_SZ, &tpl, &values[1]);
+    } else {
+      memcpy(out, fillOrder_encoded, ABI_SELECTOR_SZ);
+      n = ABI_SELECTOR_SZ + abi_encode_values(out + ABI_SELECTOR_SZ, BENCH_OUT_SZ - ABI_SELECTOR_SZ, 
+                                              fillOrder_abi, ARRAY_SIZE(fillOrder_abi), values, 3);
+    }
+    assert(n == (int) sizeof(fillOrder_encoded));
+  }
+  return CALL_ITERS / (now() - start);
+}
+
+int main() {
+  printf("=============================\n\r");
+  printf(" RUNNING ABI BENCHMARKS...\n\r");
+  printf("=============================\n\r");
+  const char * variantNames[] = { "auto", "scalar", "SSSE3", "AVX2" };
+  printf("Using %s kernels\n\r", variantNames[abi_get_kernels()]);
+  build_block();
+  printf("Block of %d transactions, %d iterations\n\r", BLOCK_NUM_TXS, BLOCK_ITERS);
+  printf("Sequential walk decode............%12.0f tx/s\n\r", bench_sequential(ABI_DECODE_DEFAULT));
+  printf("Sequential walk decode (strict)...%12.0f tx/s\n\r", bench_sequential(ABI_DECODE_STRICT));
+  printf("Selector matching.................%12.0f tx/s\n\r", bench_match_selectors());
+  long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+  for (size_t numThreads = 1; numThreads <= (size_t) (numCpus > 0 ? numCpus : 1); numThreads *= 2)
+    printf("Block decode (%2zu threads).........%12.0f tx/s\n\r", numThreads, bench_block(numThreads));
+  for (size_t numWorkers = 1; numWorkers <= (size_t) (numCpus > 0 ? numCpus : 1); numWorkers *= 2)
+    printf("Pool decode (%2zu workers)..........%12.0f tx/s\n\r", numWorkers, bench_pool(numWorkers));
+  build_address_array();
+  printf("address[] of %d elements, %d iterations\n\r", ARRAY_NUM_ELEMS, ARRAY_ITERS);
+  printf("Per-element decode................%12.0f elem/s\n\r", bench_array_elems());
+  printf("Bulk decode.......................%12.0f elem/s\n\r", bench_array_bulk(addressArray_abi, ABI_DECODE_DEFAULT));
+  printf("Bulk decode (strict)..............%12.0f elem/s\n\r", bench_array_bulk(addressArray_abi, ABI_DECODE_STRICT));
+  printf("Encode............................%12.0f elem/s\n\r", bench_array_encode());
+  printf("Encode (descriptors)..............%12.0f elem/s\n\r", bench_array_encode_values());
+  printf("uint256[] of %d elements, %d iterations\n\r", ARRAY_NUM_ELEMS, ARRAY_ITERS);
+  printf("Bulk decode.......................%12.0f elem/s\n\r", bench_array_bulk(uintArray_abi, ABI_DECODE_DEFAULT));
+  printf("Bulk decode (native endian).......%12.0f elem/s\n\r", bench_array_bulk(uintArray_abi, ABI_DECODE_NATIVE_ENDIAN));
+  printf("Hex decode........................%12.0f MB/s\n\r", bench_hex_decode());
+  printf("Hex encode........................%12.0f MB/s\n\r", bench_hex_encode());
+  printf("Calldata stats....................%12.0f MB/s\n\r", bench_calldata_stats());
+  printf("Address column to hex.............%12.0f elem/s\n\r", bench_address_hex(ABI_HEX_DEFAULT));
+  printf("Address column to hex (EIP-55)....%12.0f elem/s\n\r", bench_address_hex(ABI_HEX_CHECKSUM));
+  printf("fillOrder calls, %d iterations\n\r", CALL_ITERS);
+  printf("Encode from scratch...............%12.0f call/s\n\r", bench_fill_order(false));
+  printf("Encode from template..............%12.0f call/s\n\r", bench_fill_order(true));
+  printf("=============================\n\r");
+  return 0;
+}
@@ -1,10 +1,15 @@
 #include "abi.h"
+#include "abi_block.h"
 #include "test_vec.h"
 #include <assert.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #define ARRAY_SIZE(a) sizeof(a)/sizeof(a[0])
+// Column used by `test_u256_agg`
+#define AGG_NUM_WORDS 300
+#define AGG_STRIDE (2 * ABI_WORD_SZ)
 
 //===============================================================
 // TESTS
@@ -2011,7 +2016,15 @@ static inline void test_tupleMulti14(uint8_t * out, size_t outSz) {
   assert(decSz == sizeof(tupleMulti14_p0_6));
   assert(0 == memcmp(tupleMulti14_p0_6, out, sizeof(tupleMulti14_p0_6)));
   memset(out, 0, outSz);
+  // The second tuple item starts after all 7 words of the first
+  info.arrIdx = 1;
   paramInfo.arrIdx = 0;
+  decSz = abi_decode_tuple_param( out, outSz, tupleMulti14_abi, ARRAY_SIZE(tupleMulti14_abi),
+                                  info, paramInfo, in, inSz);
+  assert(decSz == 32);
+  assert(0 == memcmp(in + (7 * 32), out, decSz));
+  memset(out, 0, outSz);
+  info.arrIdx = 0;
   paramInfo.typeIdx = 0;
   info.typeIdx = 1;
   decSz = abi_decode_param( out, outSz, tupleMulti14_abi, ARRAY_SIZE(tupleMulti14_abi), info, in, inSz);
@@ -2047,33 +2060,1831 @@ static inline void test_enc(uint8_t * out, size_t outSz) {
   encSz = abi_encode( out, outSz, enc_ex1_abi, ARRAY_SIZE(enc_ex1_abi), 
                       enc_ex1_offsets, enc_ex1_params, sizeof(enc_ex1_params));
   assert(sizeof(enc_ex1_encoded) == encSz);
+  assert((int) encSz == abi_encoded_size(enc_ex1_abi, ARRAY_SIZE(enc_ex1_abi), enc_ex1_offsets, 
+                                        enc_ex1_params, sizeof(enc_ex1_params)));
   assert(0 == memcmp(out, enc_ex1_encoded, sizeof(enc_ex1_encoded)));
   memset(out, 0, outSz);
 
   encSz = abi_encode( out, outSz, enc_ex2_abi, ARRAY_SIZE(enc_ex2_abi), 
                       enc_ex2_offsets, enc_ex2_params, sizeof(enc_ex2_params));
   assert(sizeof(enc_ex2_encoded) == encSz);
+  assert((int) encSz == abi_encoded_size(enc_ex2_abi, ARRAY_SIZE(enc_ex2_abi), enc_ex2_offsets, 
+                                        enc_ex2_params, sizeof(enc_ex2_params)));
   assert(0 == memcmp(out, enc_ex2_encoded, sizeof(enc_ex2_encoded)));
   memset(out, 0, outSz);
 
   encSz = abi_encode( out, outSz, enc_ex3_abi, ARRAY_SIZE(enc_ex3_abi), 
                       enc_ex3_offsets, enc_ex3_params, sizeof(enc_ex3_params));
   assert(sizeof(enc_ex3_encoded) == encSz);
+  assert((int) encSz == abi_encoded_size(enc_ex3_abi, ARRAY_SIZE(enc_ex3_abi), enc_ex3_offsets, 
+                                        enc_ex3_params, sizeof(enc_ex3_params)));
   assert(0 == memcmp(out, enc_ex3_encoded, sizeof(enc_ex3_encoded)));
   memset(out, 0, outSz);
 
   encSz = abi_encode( out, outSz, enc_ex4_abi, ARRAY_SIZE(enc_ex4_abi), 
                       enc_ex4_offsets, enc_ex4_params, sizeof(enc_ex4_params));
   assert(sizeof(enc_ex4_encoded) == encSz);
+  assert((int) encSz == abi_encoded_size(enc_ex4_abi, ARRAY_SIZE(enc_ex4_abi), enc_ex4_offsets, 
+                                        enc_ex4_params, sizeof(enc_ex4_params)));
   assert(0 == memcmp(out, enc_ex4_encoded, sizeof(enc_ex4_encoded)));
   memset(out, 0, outSz);
 
   encSz = abi_encode( out, outSz, enc_ex5_abi, ARRAY_SIZE(enc_ex5_abi), 
                       enc_ex5_offsets, enc_ex5_params, sizeof(enc_ex5_params));
   assert(sizeof(enc_ex5_encoded) == encSz);
+  assert((int) encSz == abi_encoded_size(enc_ex5_abi, ARRAY_SIZE(enc_ex5_abi), enc_ex5_offsets, 
+                                        enc_ex5_params, sizeof(enc_ex5_params)));
   assert(0 == memcmp(out, enc_ex5_encoded, sizeof(enc_ex5_encoded)));
   memset(out, 0, outSz);
 
+  // f(int8, uint16, bool, int8[]): values which do not fit their types are rejected when sizing too
+  ABI_t fit_abi[4] = { { .type = ABI_INT8 }, { .type = ABI_UINT16 }, { .type = ABI_BOOL },
+                       { .type = ABI_INT8, .isArray = true } };
+  uint8_t fit_params[5 + (2 * ABI_WORD_SZ)] = { 0xff, 0xff, 0x01, 0x00, 0x01 };
+  memset(fit_params + 5, 0xff, 2 * ABI_WORD_SZ);
+  size_t fit_offsets[4] = { 0, 2, 4, 5 };
+  encSz = abi_encode(out, outSz, fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params));
+  assert(encSz == 7 * ABI_WORD_SZ);
+  assert((int) encSz == abi_encoded_size(fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  // int8 given as 0x0100
+  fit_params[0] = 0x01;
+  fit_params[1] = 0x00;
+  assert(-1 == abi_encode(out, outSz, fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  assert(-1 == abi_encoded_size(fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  fit_params[0] = 0xff;
+  fit_params[1] = 0xff;
+  // uint16 given as three bytes
+  fit_offsets[1] = 1;
+  assert(-1 == abi_encode(out, outSz, fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  assert(-1 == abi_encoded_size(fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  fit_offsets[1] = 2;
+  // bool given as 2
+  fit_params[4] = 0x02;
+  assert(-1 == abi_encode(out, outSz, fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  assert(-1 == abi_encoded_size(fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  fit_params[4] = 0x01;
+  // int8 array element whose upper bytes are not its sign extension
+  assert((int) encSz == abi_encode(out, outSz, fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  fit_params[5 + ABI_WORD_SZ] = 0x00;
+  assert(-1 == abi_encode(out, outSz, fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  assert(-1 == abi_encoded_size(fit_abi, 4, fit_offsets, fit_params, sizeof(fit_params)));
+  memset(out, 0, outSz);
+
+  printf("passed.\n\r");
+}
+
+static inline void test_enc_arrays(uint8_t * out, size_t outSz) {
+  printf("Encoding elementary arrays...");
+  ABISelector_t info = { 0 };
+  int encSz;
+  // ex5: f(uint[3], uint[]) (the second element of the variable size array is 0x37)
+  uint8_t ex5_params[5 * ABI_WORD_SZ] = { 0 };
+  memcpy(ex5_params, ex5_param_00, ABI_WORD_SZ);
+  memcpy(ex5_params + ABI_WORD_SZ, ex5_param_01, ABI_WORD_SZ);
+  memcpy(ex5_params + (2 * ABI_WORD_SZ), ex5_param_02, ABI_WORD_SZ);
+  memcpy(ex5_params + (3 * ABI_WORD_SZ), ex5_param_10, ABI_WORD_SZ);
+  ex5_params[sizeof(ex5_params) - 1] = 0x37;
+  size_t ex5_offsets[2] = { 0, 3 * ABI_WORD_SZ };
+  memset(out, 0xff, outSz);
+  encSz = abi_encode(out, outSz, ex5_abi, ARRAY_SIZE(ex5_abi), ex5_offsets, ex5_params, sizeof(ex5_params));
+  assert(encSz == (int) sizeof(ex5_encoded) - 4);
+  assert(0 == memcmp(out, ex5_encoded + 4, encSz));
+  info.typeIdx = 1;
+  info.arrIdx = 0;
+  uint8_t decoded[ABI_WORD_SZ];
+  assert(ABI_WORD_SZ == abi_decode_param(decoded, sizeof(decoded), ex5_abi, ARRAY_SIZE(ex5_abi), info, out, encSz));
+  assert(0 == memcmp(decoded, ex5_param_10, ABI_WORD_SZ));
+
+  // ex9: f(address,address[1],address[],bool)
+  uint8_t ex9_params[(4 * 20) + 1];
+  memcpy(ex9_params, ex9_param_0, 20);
+  memcpy(ex9_params + 20, ex9_param_10, 20);
+  memcpy(ex9_params + 40, ex9_param_20, 20);
+  memcpy(ex9_params + 60, ex9_param_21, 20);
+  ex9_params[80] = ex9_param_3[0];
+  size_t ex9_offsets[4] = { 0, 20, 40, 80 };
+  encSz = abi_encode(out, outSz, ex9_abi, ARRAY_SIZE(ex9_abi), ex9_offsets, ex9_params, sizeof(ex9_params));
+  assert(encSz == (int) sizeof(ex9_encoded));
+  assert(0 == memcmp(out, ex9_encoded, encSz));
+  info.typeIdx = 2;
+  info.arrIdx = 1;
+  assert(20 == abi_decode_param(decoded, sizeof(decoded), ex9_abi, ARRAY_SIZE(ex9_abi), info, out, encSz));
+  assert(0 == memcmp(decoded, ex9_param_21, 20));
+  // Element data must be whole elements, and fixed size arrays must be full
+  ex9_offsets[3] = 79;
+  assert(-1 == abi_encode(out, outSz, ex9_abi, ARRAY_SIZE(ex9_abi), ex9_offsets, ex9_params, sizeof(ex9_params)));
+  assert(-1 == abi_encoded_size(ex9_abi, ARRAY_SIZE(ex9_abi), ex9_offsets, ex9_params, sizeof(ex9_params)));
+  ex9_offsets[3] = 80;
+  ex9_offsets[2] = 60;
+  assert(-1 == abi_encode(out, outSz, ex9_abi, ARRAY_SIZE(ex9_abi), ex9_offsets, ex9_params, sizeof(ex9_params)));
+  assert(-1 == abi_encoded_size(ex9_abi, ARRAY_SIZE(ex9_abi), ex9_offsets, ex9_params, sizeof(ex9_params)));
+
+  // ex10: f(uint[3], uint[]), with an array decoded by `abi_decode_array` going straight back in
+  uint8_t ex10_params[5 * ABI_WORD_SZ];
+  memcpy(ex10_params, ex10_param_00, ABI_WORD_SZ);
+  memcpy(ex10_params + ABI_WORD_SZ, ex10_param_01, ABI_WORD_SZ);
+  memcpy(ex10_params + (2 * ABI_WORD_SZ), ex10_param_02, ABI_WORD_SZ);
+  info.typeIdx = 1;
+  assert(2 == abi_decode_array( ex10_params + (3 * ABI_WORD_SZ), 2 * ABI_WORD_SZ, ex10_abi, ARRAY_SIZE(ex10_abi), 
+                                info, ex10_encoded, sizeof(ex10_encoded), 0));
+  size_t ex10_offsets[2] = { 0, 3 * ABI_WORD_SZ };
+  encSz = abi_encode(out, outSz, ex10_abi, ARRAY_SIZE(ex10_abi), ex10_offsets, ex10_params, sizeof(ex10_params));
+  assert(encSz == (int) sizeof(ex10_encoded));
+  assert(encSz == abi_encoded_size(ex10_abi, ARRAY_SIZE(ex10_abi), ex10_offsets, ex10_params, sizeof(ex10_params)));
+  assert(0 == memcmp(out, ex10_encoded, encSz));
+  assert(-1 == abi_encode(out, encSz - 1, ex10_abi, ARRAY_SIZE(ex10_abi), ex10_offsets, ex10_params, sizeof(ex10_params)));
+
+  // Empty variable size arrays are just a length word
+  encSz = abi_encode(out, outSz, ex10_abi, ARRAY_SIZE(ex10_abi), ex10_offsets, ex10_params, 3 * ABI_WORD_SZ);
+  assert(encSz == 5 * ABI_WORD_SZ);
+  assert(encSz == abi_encoded_size(ex10_abi, ARRAY_SIZE(ex10_abi), ex10_offsets, ex10_params, 3 * ABI_WORD_SZ));
+  assert(0 == memcmp(out, ex10_encoded, 4 * ABI_WORD_SZ));
+  assert(0 == abi_get_array_sz(ex10_abi, ARRAY_SIZE(ex10_abi), info, out, encSz));
+
+  // Values must fit their type: signed values may only be extended by their sign, and bools are 0 or 1
+  ABI_t fit_abi[2] = { { .type = ABI_INT8, .isArray = true }, { .type = ABI_BOOL } };
+  uint8_t minusOne[ABI_WORD_SZ], wide[2] = { 0x01, 0x00 }, negWide[2] = { 0xff, 0x80 }, b = 1;
+  memset(minusOne, 0xff, sizeof(minusOne));
+  ABIValue_t fit_elems[3] = { { minusOne, sizeof(minusOne) }, { negWide, 2 }, { &b, 1 } };
+  ABIValue_t fit_values[2] = { { fit_elems, 3 }, { &b, 1 } };
+  encSz = abi_encode_values(out, outSz, fit_abi, 2, fit_values, 2);
+  assert(encSz == 6 * ABI_WORD_SZ);
+  assert(true == abi_is_canonical_payload(fit_abi, 2, out, encSz));
+  fit_elems[1].ptr = wide;
+  assert(-1 == abi_encode_values(out, outSz, fit_abi, 2, fit_values, 2));
+  negWide[1] = 0x7f;
+  fit_elems[1].ptr = negWide;
+  assert(-1 == abi_encode_values(out, outSz, fit_abi, 2, fit_values, 2));
+  fit_elems[1].len = 1;
+  b = 2;
+  assert(-1 == abi_encode_values(out, outSz, fit_abi, 2, fit_values, 2));
+  printf("passed.\n\r");
+}
+
+// Append an element of an array of dynamic types, prefixed by its 4-byte big endian size
+static size_t frame_elem(uint8_t * buf, size_t pos, const uint8_t * data, size_t sz) {
+  buf[pos] = (uint8_t) (sz >> 24);
+  buf[pos + 1] = (uint8_t) (sz >> 16);
+  buf[pos + 2] = (uint8_t) (sz >> 8);
+  buf[pos + 3] = (uint8_t) sz;
+  memcpy(buf + pos + 4, data, sz);
+  return pos + 4 + sz;
+}
+
+static inline void test_enc_dynamic_arrays(uint8_t * out, size_t outSz) {
+  printf("Encoding dynamic arrays...");
+  static uint8_t enc[1024];
+  uint8_t params[512];
+  size_t pos;
+  int encSz;
+  ABISelector_t info = { 0 };
+
+  // ex6: f(string[2], string[], string[1])
+  size_t ex6_offsets[3];
+  pos = 0;
+  ex6_offsets[0] = pos;
+  pos = frame_elem(params, pos, ex6_param_00, sizeof(ex6_param_00));
+  pos = frame_elem(params, pos, ex6_param_01, sizeof(ex6_param_01));
+  ex6_offsets[1] = pos;
+  pos = frame_elem(params, pos, ex6_param_10, sizeof(ex6_param_10));
+  pos = frame_elem(params, pos, ex6_param_11, sizeof(ex6_param_11));
+  pos = frame_elem(params, pos, ex6_param_12, sizeof(ex6_param_12));
+  ex6_offsets[2] = pos;
+  pos = frame_elem(params, pos, ex6_param_20, sizeof(ex6_param_20));
+  memset(enc, 0xff, sizeof(enc));
+  encSz = abi_encode(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), ex6_offsets, params, pos);
+  assert(encSz == (int) sizeof(ex6_encoded));
+  assert(encSz == abi_encoded_size(ex6_abi, ARRAY_SIZE(ex6_abi), ex6_offsets, params, pos));
+  assert(0 == memcmp(enc, ex6_encoded, encSz));
+  info.typeIdx = 1;
+  info.arrIdx = 2;
+  assert(sizeof(ex6_param_12) == abi_decode_param(out, outSz, ex6_abi, ARRAY_SIZE(ex6_abi), info, enc, encSz));
+  assert(0 == memcmp(out, ex6_param_12, sizeof(ex6_param_12)));
+  // Fixed size arrays must have exactly their number of elements
+  assert(-1 == abi_encode(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), ex6_offsets, params, pos + 4));
+  assert(-1 == abi_encoded_size(ex6_abi, ARRAY_SIZE(ex6_abi), ex6_offsets, params, pos + 4));
+  ex6_offsets[1] -= 4 + sizeof(ex6_param_01);
+  assert(-1 == abi_encode(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), ex6_offsets, params, pos));
+
+  // ex11: f(bytes, bytes[5], bool)
+  size_t ex11_offsets[3];
+  pos = 0;
+  ex11_offsets[0] = pos;
+  memcpy(params, ex11_param_0, sizeof(ex11_param_0));
+  pos += sizeof(ex11_param_0);
+  ex11_offsets[1] = pos;
+  pos = frame_elem(params, pos, ex11_param_10, sizeof(ex11_param_10));
+  pos = frame_elem(params, pos, ex11_param_11, sizeof(ex11_param_11));
+  pos = frame_elem(params, pos, ex11_param_12, sizeof(ex11_param_12));
+  pos = frame_elem(params, pos, ex11_param_13, sizeof(ex11_param_13));
+  pos = frame_elem(params, pos, ex11_param_14, sizeof(ex11_param_14));
+  ex11_offsets[2] = pos;
+  params[pos++] = ex11_param_2[0];
+  encSz = abi_encode(enc, sizeof(enc), ex11_abi, ARRAY_SIZE(ex11_abi), ex11_offsets, params, pos);
+  assert(encSz == (int) sizeof(ex11_encoded));
+  assert(encSz == abi_encoded_size(ex11_abi, ARRAY_SIZE(ex11_abi), ex11_offsets, params, pos));
+  assert(0 == memcmp(enc, ex11_encoded, encSz));
+  assert(-1 == abi_encode(enc, encSz - 1, ex11_abi, ARRAY_SIZE(ex11_abi), ex11_offsets, params, pos));
+  // Elements which overrun their param are rejected
+  params[ex11_offsets[1] + 3] += 1;
+  assert(-1 == abi_encode(enc, sizeof(enc), ex11_abi, ARRAY_SIZE(ex11_abi), ex11_offsets, params, pos));
+  assert(-1 == abi_encoded_size(ex11_abi, ARRAY_SIZE(ex11_abi), ex11_offsets, params, pos));
+  params[ex11_offsets[1] + 3] -= 1;
+
+  // ex12: f(bytes[3], bytes, uint32, bytes[2])
+  size_t ex12_offsets[4];
+  pos = 0;
+  ex12_offsets[0] = pos;
+  pos = frame_elem(params, pos, ex12_param_00, sizeof(ex12_param_00));
+  pos = frame_elem(params, pos, ex12_param_01, sizeof(ex12_param_01));
+  pos = frame_elem(params, pos, ex12_param_02, sizeof(ex12_param_02));
+  ex12_offsets[1] = pos;
+  memcpy(params + pos, ex12_param_1, sizeof(ex12_param_1));
+  pos += sizeof(ex12_param_1);
+  ex12_offsets[2] = pos;
+  params[pos++] = (uint8_t) (ex12_param_2 >> 24);
+  params[pos++] = (uint8_t) (ex12_param_2 >> 16);
+  params[pos++] = (uint8_t) (ex12_param_2 >> 8);
+  params[pos++] = (uint8_t) ex12_param_2;
+  ex12_offsets[3] = pos;
+  pos = frame_elem(params, pos, ex12_param_30, sizeof(ex12_param_30));
+  pos = frame_elem(params, pos, ex12_param_31, sizeof(ex12_param_31));
+  encSz = abi_encode(enc, sizeof(enc), ex12_abi, ARRAY_SIZE(ex12_abi), ex12_offsets, params, pos);
+  assert(encSz == (int) sizeof(ex12_encoded));
+  assert(encSz == abi_encoded_size(ex12_abi, ARRAY_SIZE(ex12_abi), ex12_offsets, params, pos));
+  assert(0 == memcmp(enc, ex12_encoded, encSz));
+  info.typeIdx = 3;
+  info.arrIdx = 1;
+  assert(sizeof(ex12_param_31) == abi_decode_param(out, outSz, ex12_abi, ARRAY_SIZE(ex12_abi), info, enc, encSz));
+  assert(0 == memcmp(out, ex12_param_31, sizeof(ex12_param_31)));
+
+  // ex13: f(bytes[], string[])
+  size_t ex13_offsets[2];
+  pos = 0;
+  ex13_offsets[0] = pos;
+  pos = frame_elem(params, pos, ex13_param_00, sizeof(ex13_param_00));
+  pos = frame_elem(params, pos, ex13_param_01, sizeof(ex13_param_01));
+  ex13_offsets[1] = pos;
+  pos = frame_elem(params, pos, ex13_param_10, sizeof(ex13_param_10));
+  pos = frame_elem(params, pos, ex13_param_11, sizeof(ex13_param_11));
+  encSz = abi_encode(enc, sizeof(enc), ex13_abi, ARRAY_SIZE(ex13_abi), ex13_offsets, params, pos);
+  assert(encSz == (int) sizeof(ex13_encoded));
+  assert(encSz == abi_encoded_size(ex13_abi, ARRAY_SIZE(ex13_abi), ex13_offsets, params, pos));
+  assert(0 == memcmp(enc, ex13_encoded, encSz));
+  // Empty arrays are just a length word
+  encSz = abi_encode(enc, sizeof(enc), ex13_abi, ARRAY_SIZE(ex13_abi), ex13_offsets, params, ex13_offsets[1]);
+  assert(encSz == (int) sizeof(ex13_encoded) - (6 * ABI_WORD_SZ));
+  info.typeIdx = 1;
+  assert(0 == abi_get_array_sz(ex13_abi, ARRAY_SIZE(ex13_abi), info, enc, encSz));
+  printf("passed.\n\r");
+}
+
+static int decode_enc_value(uint8_t * out, 
+                            size_t outSz, 
+                            const ABI_t * types, 
+                            size_t numTypes, 
+                            bool isTupleParam, 
+                            ABISelector_t tupleInfo, 
+                            ABISelector_t info, 
+                            const uint8_t * in, 
+                            size_t inSz)
+{
+  if (isTupleParam)
+    return abi_decode_tuple_param(out, outSz, types, numTypes, tupleInfo, info, in, inSz);
+  return abi_decode_param(out, outSz, types, numTypes, info, in, inSz);
+}
+
+// Write the 4-byte big endian size of the value framed at `buf + pos`
+static void set_frame_sz(uint8_t * buf, size_t pos, size_t end) {
+  size_t sz = end - pos - 4;
+  buf[pos] = (uint8_t) (sz >> 24);
+  buf[pos + 1] = (uint8_t) (sz >> 16);
+  buf[pos + 2] = (uint8_t) (sz >> 8);
+  buf[pos + 3] = (uint8_t) sz;
+}
+
+// Decode the param at schema index `idx` (selected by `typeIdx`, which is relative to the
+// tuple for tuple params) back into the `abi_encode` input format at `buf + pos`.
+// Returns the new end of the input data.
+static size_t build_enc_param(uint8_t * buf, 
+                              size_t pos, 
+                              const ABI_t * types, 
+                              size_t numTypes, 
+                              bool isTupleParam, 
+                              ABISelector_t tupleInfo, 
+                              size_t idx, 
+                              size_t typeIdx, 
+                              const uint8_t * in, 
+                              size_t inSz)
+{
+  ABI_t type = types[idx];
+  ABISelector_t info = { .typeIdx = typeIdx };
+  size_t count = 1;
+  if (type.isArray && type.arraySz > 0) {
+    count = type.arraySz;
+  } else if (type.isArray) {
+    int sz = isTupleParam ? abi_get_tuple_param_array_sz(types, numTypes, tupleInfo, info, in, inSz) :
+                            abi_get_array_sz(types, numTypes, info, in, inSz);
+    assert(sz >= 0);
+    count = sz;
+  }
+  bool framed = type.isArray && (is_tuple_type(type) || type.type == ABI_BYTES || type.type == ABI_STRING);
+  for (size_t i = 0; i < count; i++) {
+    size_t start = pos;
+    if (framed)
+      pos += 4;
+    if (is_tuple_type(type)) {
+      // Params of a tuple follow the tuple params of every later root tuple
+      size_t firstIdx = numTypes - get_tuple_sz(type);
+      for (size_t j = idx + 1; j < numTypes; j++)
+        if (is_tuple_type(types[j]))
+          firstIdx -= get_tuple_sz(types[j]);
+      ABISelector_t elemInfo = { .typeIdx = typeIdx, .arrIdx = i };
+      for (int j = 0; j < get_tuple_sz(type); j++) {
+        size_t paramStart = pos;
+        pos = build_enc_param(buf, pos + 4, types, numTypes, true, elemInfo, firstIdx + j, j, in, inSz);
+        set_frame_sz(buf, paramStart, pos);
+      }
+    } else {
+      info.arrIdx = i;
+      int sz = decode_enc_value(buf + pos, 4096, types, numTypes, isTupleParam, tupleInfo, info, in, inSz);
+      assert(sz >= 0);
+      pos += sz;
+    }
+    if (framed)
+      set_frame_sz(buf, start, pos);
+  }
+  return pos;
+}
+
+static inline void test_enc_tuples(void) {
+  printf("Encoding tuples...");
+  // tupleMulti9's payload only holds one item of its first tuple array (see its comment)
+  static ABI_t tupleMulti9_abi1[ARRAY_SIZE(tupleMulti9_abi)];
+  memcpy(tupleMulti9_abi1, tupleMulti9_abi, sizeof(tupleMulti9_abi));
+  tupleMulti9_abi1[0].arraySz = 1;
+  static const struct {
+    const ABI_t * abi;
+    size_t numTypes;
+    const uint8_t * encoded;
+    size_t encodedSz;
+  } vecs[] = {
+    { fillOrder_abi, ARRAY_SIZE(fillOrder_abi), fillOrder_encoded + 4, sizeof(fillOrder_encoded) - 4 },
+    { marketSellOrders_abi, ARRAY_SIZE(marketSellOrders_abi), marketSellOrders_encoded + 4, sizeof(marketSellOrders_encoded) - 4 },
+    { tupleElementary_abi, ARRAY_SIZE(tupleElementary_abi), tupleElementary_encoded, sizeof(tupleElementary_encoded) },
+    { tupleFixedArray0_abi, ARRAY_SIZE(tupleFixedArray0_abi), tupleFixedArray0_encoded, sizeof(tupleFixedArray0_encoded) },
+    { tupleFixedArray1_abi, ARRAY_SIZE(tupleFixedArray1_abi), tupleFixedArray1_encoded, sizeof(tupleFixedArray1_encoded) },
+    { tupleVarArray0_abi, ARRAY_SIZE(tupleVarArray0_abi), tupleVarArray0_encoded, sizeof(tupleVarArray0_encoded) },
+    { tupleVarArray1_abi, ARRAY_SIZE(tupleVarArray1_abi), tupleVarArray1_encoded, sizeof(tupleVarArray1_encoded) },
+    { tupleVarArray2_abi, ARRAY_SIZE(tupleVarArray2_abi), tupleVarArray2_encoded, sizeof(tupleVarArray2_encoded) },
+    { tupleVarArray3_abi, ARRAY_SIZE(tupleVarArray3_abi), tupleVarArray3_encoded, sizeof(tupleVarArray3_encoded) },
+    { tupleVarArray4_abi, ARRAY_SIZE(tupleVarArray4_abi), tupleVarArray4_encoded, sizeof(tupleVarArray4_encoded) },
+    { tupleMulti1_abi, ARRAY_SIZE(tupleMulti1_abi), tupleMulti1_encoded, sizeof(tupleMulti1_encoded) },
+    { tupleMulti2_abi, ARRAY_SIZE(tupleMulti2_abi), tupleMulti2_encoded, sizeof(tupleMulti2_encoded) },
+    { tupleMulti3_abi, ARRAY_SIZE(tupleMulti3_abi), tupleMulti3_encoded, sizeof(tupleMulti3_encoded) },
+    { tupleMulti4_abi, ARRAY_SIZE(tupleMulti4_abi), tupleMulti4_encoded, sizeof(tupleMulti4_encoded) },
+    { tupleMulti5_abi, ARRAY_SIZE(tupleMulti5_abi), tupleMulti5_encoded, sizeof(tupleMulti5_encoded) },
+    { tupleMulti6_abi, ARRAY_SIZE(tupleMulti6_abi), tupleMulti6_encoded, sizeof(tupleMulti6_encoded) },
+    { tupleMulti7_abi, ARRAY_SIZE(tupleMulti7_abi), tupleMulti7_encoded, sizeof(tupleMulti7_encoded) },
+    { tupleMulti8_abi, ARRAY_SIZE(tupleMulti8_abi), tupleMulti8_encoded, sizeof(tupleMulti8_encoded) },
+    { tupleMulti9_abi1, ARRAY_SIZE(tupleMulti9_abi1), tupleMulti9_encoded, sizeof(tupleMulti9_encoded) },
+    { tupleMulti10_abi, ARRAY_SIZE(tupleMulti10_abi), tupleMulti10_encoded, sizeof(tupleMulti10_encoded) },
+    { tupleMulti11_abi, ARRAY_SIZE(tupleMulti11_abi), tupleMulti11_encoded, sizeof(tupleMulti11_encoded) },
+    { tupleMulti12_abi, ARRAY_SIZE(tupleMulti12_abi), tupleMulti12_encoded, sizeof(tupleMulti12_encoded) },
+    { tupleMulti13_abi, ARRAY_SIZE(tupleMulti13_abi), tupleMulti13_encoded, sizeof(tupleMulti13_encoded) },
+    { tupleMulti14_abi, ARRAY_SIZE(tupleMulti14_abi), tupleMulti14_encoded, sizeof(tupleMulti14_encoded) },
+  };
+  static uint8_t params[8192];
+  static uint8_t enc[4096];
+  size_t offsets[8];
+  ABISelector_t noTuple = { .typeIdx = 0 };
+  for (size_t v = 0; v < ARRAY_SIZE(vecs); v++) {
+    // Decode every param and encode them again; the payload must match byte for byte
+    size_t numRoot = vecs[v].numTypes;
+    for (size_t i = 0; i < vecs[v].numTypes; i++)
+      if (is_tuple_type(vecs[v].abi[i]))
+        numRoot -= get_tuple_sz(vecs[v].abi[i]);
+    assert(numRoot <= ARRAY_SIZE(offsets));
+    size_t pos = 0;
+    for (size_t i = 0; i < numRoot; i++) {
+      offsets[i] = pos;
+      pos = build_enc_param(params, pos, vecs[v].abi, vecs[v].numTypes, false, noTuple, i, i, 
+                            vecs[v].encoded, vecs[v].encodedSz);
+    }
+    memset(enc, 0xff, sizeof(enc));
+    int encSz = abi_encode(enc, sizeof(enc), vecs[v].abi, vecs[v].numTypes, offsets, params, pos);
+    assert(encSz > 0 && encSz <= (int) vecs[v].encodedSz);
+    assert(encSz == abi_encoded_size(vecs[v].abi, vecs[v].numTypes, offsets, params, pos));
+    assert(0 == memcmp(enc, vecs[v].encoded, encSz));
+    // Some vectors are declared larger than their payload and zero padded
+    for (size_t i = encSz; i < vecs[v].encodedSz; i++)
+      assert(0 == vecs[v].encoded[i]);
+    assert(-1 == abi_encode(enc, encSz - 1, vecs[v].abi, vecs[v].numTypes, offsets, params, pos));
+  }
+
+  // Tuple params must be framed exactly: fillOrder's first param is a tuple of 12 params
+  size_t pos = 0;
+  offsets[0] = pos;
+  pos = build_enc_param(params, pos, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), false, noTuple, 0, 0, 
+                        fillOrder_encoded + 4, sizeof(fillOrder_encoded) - 4);
+  offsets[1] = pos;
+  pos = build_enc_param(params, pos, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), false, noTuple, 1, 1, 
+                        fillOrder_encoded + 4, sizeof(fillOrder_encoded) - 4);
+  offsets[2] = pos;
+  pos = build_enc_param(params, pos, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), false, noTuple, 2, 2, 
+                        fillOrder_encoded + 4, sizeof(fillOrder_encoded) - 4);
+  assert(sizeof(fillOrder_encoded) - 4 == 
+         (size_t) abi_encode(enc, sizeof(enc), fillOrder_abi, ARRAY_SIZE(fillOrder_abi), offsets, params, pos));
+  params[3] += 1;
+  assert(-1 == abi_encode(enc, sizeof(enc), fillOrder_abi, ARRAY_SIZE(fillOrder_abi), offsets, params, pos));
+  assert(-1 == abi_encoded_size(fillOrder_abi, ARRAY_SIZE(fillOrder_abi), offsets, params, pos));
+  params[3] -= 1;
+  size_t tupleSz = offsets[1];
+  offsets[1] -= 4;
+  assert(-1 == abi_encode(enc, sizeof(enc), fillOrder_abi, ARRAY_SIZE(fillOrder_abi), offsets, params, pos));
+  offsets[1] = tupleSz;
+
+  // Tuples nested in tuples are not supported
+  ABI_t nested[3] = { { .type = ABI_TUPLE1 }, { .type = ABI_TUPLE1 }, { .type = ABI_UINT8 } };
+  uint8_t nestedParams[9] = { 0, 0, 0, 5, 0, 0, 0, 1, 7 };
+  offsets[0] = 0;
+  assert(-1 == abi_encode(enc, sizeof(enc), nested, ARRAY_SIZE(nested), offsets, nestedParams, sizeof(nestedParams)));
+  assert(-1 == abi_encoded_size(nested, ARRAY_SIZE(nested), offsets, nestedParams, sizeof(nestedParams)));
+  printf("passed.\n\r");
+}
+
+static inline void test_enc_values(void) {
+  printf("Encoding values...");
+  static uint8_t enc[4096];
+  int encSz;
+
+  // ex6: f(string[2], string[], string[1])
+  ABIValue_t ex6_elems0[2] = { { ex6_param_00, sizeof(ex6_param_00) }, { ex6_param_01, sizeof(ex6_param_01) } };
+  ABIValue_t ex6_elems1[3] = {  { ex6_param_10, sizeof(ex6_param_10) }, 
+                                { ex6_param_11, sizeof(ex6_param_11) }, 
+                                { ex6_param_12, sizeof(ex6_param_12) } };
+  ABIValue_t ex6_elems2[1] = { { ex6_param_20, sizeof(ex6_param_20) } };
+  ABIValue_t ex6_values[3] = { { ex6_elems0, 2 }, { ex6_elems1, 3 }, { ex6_elems2, 1 } };
+  memset(enc, 0xff, sizeof(enc));
+  encSz = abi_encode_values(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), ex6_values, ARRAY_SIZE(ex6_values));
+  assert(encSz == (int) sizeof(ex6_encoded));
+  assert(0 == memcmp(enc, ex6_encoded, encSz));
+  assert(encSz == abi_encoded_values_size(ex6_abi, ARRAY_SIZE(ex6_abi), ex6_values, ARRAY_SIZE(ex6_values)));
+  assert(-1 == abi_encode_values(enc, encSz - 1, ex6_abi, ARRAY_SIZE(ex6_abi), ex6_values, ARRAY_SIZE(ex6_values)));
+  // Fixed size arrays must have exactly their number of elements, and there is one value per root param
+  ex6_values[0].len = 1;
+  assert(-1 == abi_encode_values(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), ex6_values, ARRAY_SIZE(ex6_values)));
+  assert(-1 == abi_encoded_values_size(ex6_abi, ARRAY_SIZE(ex6_abi), ex6_values, ARRAY_SIZE(ex6_values)));
+  ex6_values[0].len = 2;
+  assert(-1 == abi_encode_values(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), ex6_values, 2));
+  ex6_elems1[1].ptr = NULL;
+  assert(-1 == abi_encode_values(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), ex6_values, ARRAY_SIZE(ex6_values)));
+  ex6_elems1[1].ptr = ex6_param_11;
+
+  // ex10: f(uint[3], uint[]), where elements may be shorter than their type
+  uint8_t small = 0x2a;
+  ABIValue_t ex10_elems0[3] = {  { ex10_param_00, sizeof(ex10_param_00) }, 
+                                 { ex10_param_01, sizeof(ex10_param_01) }, 
+                                 { ex10_param_02, sizeof(ex10_param_02) } };
+  ABIValue_t ex10_elems1[3] = {  { ex10_param_10, sizeof(ex10_param_10) }, 
+                                 { ex10_param_11, sizeof(ex10_param_11) }, 
+                                 { &small, 1 } };
+  ABIValue_t ex10_values[2] = { { ex10_elems0, 3 }, { ex10_elems1, 2 } };
+  encSz = abi_encode_values(enc, sizeof(enc), ex10_abi, ARRAY_SIZE(ex10_abi), ex10_values, ARRAY_SIZE(ex10_values));
+  assert(encSz == (int) sizeof(ex10_encoded));
+  assert(0 == memcmp(enc, ex10_encoded, encSz));
+  ex10_values[1].len = 3;
+  encSz = abi_encode_values(enc, sizeof(enc), ex10_abi, ARRAY_SIZE(ex10_abi), ex10_values, ARRAY_SIZE(ex10_values));
+  assert(encSz == (int) sizeof(ex10_encoded) + ABI_WORD_SZ);
+  assert(encSz == abi_encoded_values_size(ex10_abi, ARRAY_SIZE(ex10_abi), ex10_values, ARRAY_SIZE(ex10_values)));
+  assert(3 == enc[(5 * ABI_WORD_SZ) - 1]);
+  assert(0 == enc[encSz - 2] && small == enc[encSz - 1]);
+  // ... but must still fit in it
+  ABI_t fit_abi[1] = { { .type = ABI_BOOL, .isArray = true } };
+  uint8_t bools[2] = { 1, 2 };
+  ABIValue_t fit_elems[2] = { { &bools[0], 1 }, { &bools[1], 1 } };
+  ABIValue_t fit_values[1] = { { fit_elems, 2 } };
+  assert(-1 == abi_encode_values(enc, sizeof(enc), fit_abi, 1, fit_values, 1));
+  assert(-1 == abi_encoded_values_size(fit_abi, 1, fit_values, 1));
+  bools[1] = 0;
+  encSz = abi_encode_values(enc, sizeof(enc), fit_abi, 1, fit_values, 1);
+  assert(encSz == 4 * ABI_WORD_SZ);
+  assert(encSz == abi_encoded_values_size(fit_abi, 1, fit_values, 1));
+
+  // marketSellOrders: f((address,...,bytes,bytes)[], uint256, bytes[])
+  const uint8_t * orders[3][12] = {
+    { marketSellOrders_p0_t0_p0, marketSellOrders_p0_t0_p1, marketSellOrders_p0_t0_p2, marketSellOrders_p0_t0_p3,
+      marketSellOrders_p0_t0_p4, marketSellOrders_p0_t0_p5, marketSellOrders_p0_t0_p6, marketSellOrders_p0_t0_p7,
+      marketSellOrders_p0_t0_p8, marketSellOrders_p0_t0_p9, marketSellOrders_p0_t0_p10, marketSellOrders_p0_t0_p11 },
+    { marketSellOrders_p0_t1_p0, marketSellOrders_p0_t1_p1, marketSellOrders_p0_t1_p2, marketSellOrders_p0_t1_p3,
+      marketSellOrders_p0_t1_p4, marketSellOrders_p0_t1_p5, marketSellOrders_p0_t1_p6, marketSellOrders_p0_t1_p7,
+      marketSellOrders_p0_t1_p8, marketSellOrders_p0_t1_p9, marketSellOrders_p0_t1_p10, marketSellOrders_p0_t1_p11 },
+    { marketSellOrders_p0_t2_p0, marketSellOrders_p0_t2_p1, marketSellOrders_p0_t2_p2, marketSellOrders_p0_t2_p3,
+      marketSellOrders_p0_t2_p4, marketSellOrders_p0_t2_p5, marketSellOrders_p0_t2_p6, marketSellOrders_p0_t2_p7,
+      marketSellOrders_p0_t2_p8, marketSellOrders_p0_t2_p9, marketSellOrders_p0_t2_p10, marketSellOrders_p0_t2_p11 },
+  };
+  // Every order has the same param sizes
+  const size_t orderSzs[12] = { 20, 20, 20, 20, 32, 32, 32, 32, 32, 32, 36, 36 };
+  ABIValue_t orderParams[3][12];
+  ABIValue_t orderValues[3];
+  for (size_t i = 0; i < 3; i++) {
+    for (size_t j = 0; j < 12; j++) {
+      orderParams[i][j].ptr = orders[i][j];
+      orderParams[i][j].len = orderSzs[j];
+    }
+    orderValues[i].ptr = orderParams[i];
+    orderValues[i].len = 12;
+  }
+  ABIValue_t sigs[3] = {  { marketSellOrders_p2_0, sizeof(marketSellOrders_p2_0) }, 
+                          { marketSellOrders_p2_1, sizeof(marketSellOrders_p2_1) }, 
+                          { marketSellOrders_p2_2, sizeof(marketSellOrders_p2_2) } };
+  ABIValue_t values[3] = {  { orderValues, 3 }, 
+                            { marketSellOrders_p1, sizeof(marketSellOrders_p1) }, 
+                            { sigs, 3 } };
+  memset(enc, 0xff, sizeof(enc));
+  encSz = abi_encode_values(enc, sizeof(enc), marketSellOrders_abi, ARRAY_SIZE(marketSellOrders_abi), values, 3);
+  assert(encSz == (int) sizeof(marketSellOrders_encoded) - 4);
+  assert(0 == memcmp(enc, marketSellOrders_encoded + 4, encSz));
+  assert(encSz == abi_encoded_values_size(marketSellOrders_abi, ARRAY_SIZE(marketSellOrders_abi), values, 3));
+  // Tuples must have a value for each of their params
+  orderValues[1].len = 11;
+  assert(-1 == abi_encode_values(enc, sizeof(enc), marketSellOrders_abi, ARRAY_SIZE(marketSellOrders_abi), values, 3));
+  assert(-1 == abi_encoded_values_size(marketSellOrders_abi, ARRAY_SIZE(marketSellOrders_abi), values, 3));
+  printf("passed.\n\r");
+}
+
+// Encode a call from a template and check it against encoding every value from scratch
+static void check_template_encode(const ABICallTemplate_t * tpl, 
+                                  const ABIValue_t * values, 
+                                  size_t numValues, 
+                                  const ABIValue_t * slotValues)
+{
+  static uint8_t enc[2048];
+  static uint8_t ref[2048];
+  ABIValue_t allValues[8];
+  assert(numValues <= ARRAY_SIZE(allValues));
+  memcpy(allValues, values, numValues * sizeof(ABIValue_t));
+  for (size_t i = 0; i < tpl->numSlots; i++)
+    allValues[tpl->slots[i].typeIdx] = slotValues[i];
+  memcpy(ref, tpl->payload, tpl->prefixSz);
+  int refSz = abi_encode_values(ref + tpl->prefixSz, sizeof(ref) - tpl->prefixSz, tpl->types, tpl->numTypes, 
+                                allValues, numValues);
+  assert(refSz > 0);
+  refSz += tpl->prefixSz;
+  memset(enc, 0xff, sizeof(enc));
+  assert(refSz == abi_template_encode(enc, sizeof(enc), tpl, slotValues));
+  assert(0 == memcmp(enc, ref, refSz));
+  assert(-1 == abi_template_encode(enc, refSz - 1, tpl, slotValues));
+}
+
+static inline void test_template(void) {
+  printf("Call templates...");
+  static uint8_t buf[2048];
+  static uint8_t data[256];
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = (uint8_t) (i * 13 + 1);
+  ABICallTemplate_t tpl;
+
+  // fillOrder: the order is constant, and the amount and signature vary
+  const uint8_t * order[12] = { fillOrder_p0_t0, fillOrder_p0_t1, fillOrder_p0_t2, fillOrder_p0_t3, 
+                                fillOrder_p0_t4, fillOrder_p0_t5, fillOrder_p0_t6, fillOrder_p0_t7, 
+                                fillOrder_p0_t8, fillOrder_p0_t9, fillOrder_p0_t10, fillOrder_p0_t11 };
+  const size_t orderSzs[12] = { 20, 20, 20, 20, 32, 32, 32, 32, 32, 32, 36, 36 };
+  ABIValue_t orderParams[12];
+  for (size_t i = 0; i < 12; i++) {
+    orderParams[i].ptr = order[i];
+    orderParams[i].len = orderSzs[i];
+  }
+  ABIValue_t values[3] = {  { orderParams, 12 }, 
+                            { fillOrder_p1, sizeof(fillOrder_p1) }, 
+                            { fillOrder_p2_0, sizeof(fillOrder_p2_0) } };
+  size_t slotIdxs[2] = { 1, 2 };
+  int sz = abi_template_init(&tpl, buf, sizeof(buf), fillOrder_abi, ARRAY_SIZE(fillOrder_abi), 
+                             fillOrder_encoded, values, 3, slotIdxs, 2);
+  assert(sz == (int) sizeof(fillOrder_encoded));
+  assert(0 == memcmp(buf, fillOrder_encoded, sz));
+  assert(tpl.slots[1].isDynamic && tpl.slots[1].tailSz == 4 * ABI_WORD_SZ);
+  ABIValue_t slotValues[2] = { { fillOrder_p1, sizeof(fillOrder_p1) }, { fillOrder_p2_0, sizeof(fillOrder_p2_0) } };
+  check_template_encode(&tpl, values, 3, slotValues);
+  // Same length signature: patched in place
+  slotValues[0].ptr = data;
+  slotValues[0].len = 3;
+  slotValues[1].ptr = data + 1;
+  check_template_encode(&tpl, values, 3, slotValues);
+  // Longer, shorter and empty signatures: the tail is re-laid out
+  slotValues[1].len = 200;
+  check_template_encode(&tpl, values, 3, slotValues);
+  slotValues[1].len = 10;
+  check_template_encode(&tpl, values, 3, slotValues);
+  slotValues[1].len = 0;
+  check_template_encode(&tpl, values, 3, slotValues);
+  // Values must fit their types
+  slotValues[0].len = 33;
+  assert(-1 == abi_template_encode(buf + 1024, 1024, &tpl, slotValues));
+  slotValues[0].len = 3;
+
+  // ex12: f(bytes[3], bytes, uint32, bytes[2]), where resizing the bytes moves the bytes[2] data
+  uint8_t ex12_p2[4] = { 0, 1, 0xe2, 0x40 };
+  ABIValue_t ex12_elems0[3] = {  { ex12_param_00, sizeof(ex12_param_00) }, 
+                                 { ex12_param_01, sizeof(ex12_param_01) }, 
+                                 { ex12_param_02, sizeof(ex12_param_02) } };
+  ABIValue_t ex12_elems3[2] = { { ex12_param_30, sizeof(ex12_param_30) }, { ex12_param_31, sizeof(ex12_param_31) } };
+  ABIValue_t ex12_values[4] = {  { ex12_elems0, 3 }, 
+                                 { ex12_param_1, sizeof(ex12_param_1) }, 
+                                 { ex12_p2, sizeof(ex12_p2) }, 
+                                 { ex12_elems3, 2 } };
+  size_t ex12_slotIdxs[2] = { 1, 2 };
+  sz = abi_template_init(&tpl, buf, sizeof(buf), ex12_abi, ARRAY_SIZE(ex12_abi), NULL, ex12_values, 4, ex12_slotIdxs, 2);
+  assert(sz == (int) sizeof(ex12_encoded));
+  assert(0 == memcmp(buf, ex12_encoded, sz));
+  ABIValue_t ex12_slotValues[2] = { { data, 64 }, { data, 1 } };
+  check_template_encode(&tpl, ex12_values, 4, ex12_slotValues);
+  ex12_slotValues[0].len = 33;
+  check_template_encode(&tpl, ex12_values, 4, ex12_slotValues);
+  // Array slots work the same way
+  ex12_slotIdxs[0] = 0;
+  ex12_slotIdxs[1] = 3;
+  sz = abi_template_init(&tpl, buf, sizeof(buf), ex12_abi, ARRAY_SIZE(ex12_abi), NULL, ex12_values, 4, ex12_slotIdxs, 2);
+  assert(sz == (int) sizeof(ex12_encoded));
+  ABIValue_t newElems[3] = { { data, 100 }, { data, 0 }, { data, 31 } };
+  ex12_slotValues[0].ptr = newElems;
+  ex12_slotValues[0].len = 3;
+  ex12_slotValues[1].ptr = newElems;
+  ex12_slotValues[1].len = 2;
+  check_template_encode(&tpl, ex12_values, 4, ex12_slotValues);
+
+  // Slots must be root params in increasing order
+  ex12_slotIdxs[1] = 0;
+  assert(-1 == abi_template_init(&tpl, buf, sizeof(buf), ex12_abi, ARRAY_SIZE(ex12_abi), NULL, ex12_values, 4, ex12_slotIdxs, 2));
+  ex12_slotIdxs[1] = 4;
+  assert(-1 == abi_template_init(&tpl, buf, sizeof(buf), ex12_abi, ARRAY_SIZE(ex12_abi), NULL, ex12_values, 4, ex12_slotIdxs, 2));
+  assert(-1 == abi_template_init(&tpl, buf, sizeof(buf), ex12_abi, ARRAY_SIZE(ex12_abi), NULL, ex12_values, 4, 
+                                 ex12_slotIdxs, ABI_TEMPLATE_SLOTS_MAX + 1));
+  assert(-1 == abi_template_init(&tpl, buf, sizeof(ex12_encoded) - 1, ex12_abi, ARRAY_SIZE(ex12_abi), NULL, 
+                                 ex12_values, 4, ex12_slotIdxs, 1));
+  printf("passed.\n\r");
+}
+
+static inline void test_enc_setters(void) {
+  printf("Typed setters...");
+  uint8_t word[ABI_WORD_SZ];
+  uint8_t expected[ABI_WORD_SZ];
+  uint8_t ref[ABI_WORD_SZ];
+
+  abi_enc_u64(word, 0x0102030405060708);
+  memset(expected, 0, sizeof(expected));
+  for (size_t i = 0; i < 8; i++)
+    expected[24 + i] = (uint8_t) (i + 1);
+  assert(0 == memcmp(word, expected, ABI_WORD_SZ));
+
+  // Negative values are sign extended, as when encoding an `intN` from its bytes
+  abi_enc_i64(word, -1);
+  memset(expected, 0xff, sizeof(expected));
+  assert(0 == memcmp(word, expected, ABI_WORD_SZ));
+  ABI_t int8Type[1] = { { .type = ABI_INT8 } };
+  uint8_t minus5 = 0xfb;
+  ABIValue_t minus5Value = { &minus5, 1 };
+  assert(ABI_WORD_SZ == abi_encode_values(ref, sizeof(ref), int8Type, 1, &minus5Value, 1));
+  abi_enc_i64(word, -5);
+  assert(0 == memcmp(word, ref, ABI_WORD_SZ));
+  abi_enc_i64(word, INT64_MIN);
+  assert(0xff == word[23] && 0x80 == word[24] && 0 == word[31]);
+  abi_enc_i64(word, 5);
+  assert(0 == word[0] && 5 == word[31]);
+
+  memset(word, 0xff, sizeof(word));
+  abi_enc_bool(word, true);
+  memset(expected, 0, sizeof(expected));
+  expected[31] = 1;
+  assert(0 == memcmp(word, expected, ABI_WORD_SZ));
+
+  ABI_t addressType[1] = { { .type = ABI_ADDRESS } };
+  ABIValue_t addressValue = { fillOrder_p0_t0, sizeof(fillOrder_p0_t0) };
+  assert(ABI_WORD_SZ == abi_encode_values(ref, sizeof(ref), addressType, 1, &addressValue, 1));
+  memset(word, 0xff, sizeof(word));
+  abi_enc_address(word, fillOrder_p0_t0);
+  assert(0 == memcmp(word, ref, ABI_WORD_SZ));
+
+  const uint64_t limbs[4] = { 1, 2, 3, 0x8000000000000004 };
+  abi_enc_u256_limbs(word, limbs);
+  assert(0x80 == word[0] && 4 == word[7] && 3 == word[15] && 2 == word[23] && 1 == word[31]);
+  assert(0 == word[8] && 0 == word[30]);
+
+  // Setters can patch a template's static slots directly
+  static uint8_t tplBuf[1024];
+  static uint8_t enc[1024];
+  ABICallTemplate_t tpl;
+  ABIValue_t values[3] = { { NULL, 0 }, { fillOrder_p1, sizeof(fillOrder_p1) }, { fillOrder_p2_0, sizeof(fillOrder_p2_0) } };
+  ABI_t abi[3] = { { .type = ABI_UINT64 }, { .type = ABI_UINT256 }, { .type = ABI_BYTES } };
+  uint8_t deadline[8] = { 0 };
+  values[0].ptr = deadline;
+  values[0].len = sizeof(deadline);
+  size_t slotIdx = 0;
+  int sz = abi_template_init(&tpl, tplBuf, sizeof(tplBuf), abi, 3, fillOrder_encoded, values, 3, &slotIdx, 1);
+  assert(sz > 0);
+  deadline[6] = 0x12;
+  deadline[7] = 0x34;
+  assert(sz == abi_template_encode(enc, sizeof(enc), &tpl, values));
+  abi_enc_u64(tplBuf + tpl.prefixSz + tpl.slots[0].headOff, 0x1234);
+  assert(0 == memcmp(tplBuf, enc, sz));
+  printf("passed.\n\r");
+}
+
+static inline void test_functions(void) {
+  printf("Compiled functions...");
+  static uint8_t enc[4096];
+  char sig[ABI_SIGNATURE_MAX];
+  ABIFunction_t fn;
+
+  ABI_t transfer_abi[2] = { { .type = ABI_ADDRESS }, { .type = ABI_UINT } };
+  assert(25 == abi_get_signature(sig, sizeof(sig), "transfer", transfer_abi, 2));
+  assert(0 == strcmp(sig, "transfer(address,uint256)"));
+  assert(-1 == abi_get_signature(sig, 25, "transfer", transfer_abi, 2));
+  assert(true == abi_compile_function(&fn, "transfer", transfer_abi, 2));
+  const uint8_t transferSelector[4] = { 0xa9, 0x05, 0x9c, 0xbb };
+  assert(0 == memcmp(fn.selector, transferSelector, 4));
+  uint8_t amount = 100;
+  ABIValue_t transferValues[2] = { { fillOrder_p0_t0, sizeof(fillOrder_p0_t0) }, { &amount, 1 } };
+  assert(4 + (2 * ABI_WORD_SZ) == abi_encode_call_values(enc, sizeof(enc), &fn, transferValues, 2));
+  assert(0 == memcmp(enc, transferSelector, 4));
+  assert(0 == memcmp(enc + 4 + 12, fillOrder_p0_t0, sizeof(fillOrder_p0_t0)));
+  assert(amount == enc[4 + (2 * ABI_WORD_SZ) - 1]);
+  assert(-1 == abi_encode_call_values(enc, 4 + (2 * ABI_WORD_SZ) - 1, &fn, transferValues, 2));
+
+  // Functions without params are just their selector
+  assert(true == abi_compile_function(&fn, "totalSupply", NULL, 0));
+  const uint8_t totalSupplySelector[4] = { 0x18, 0x16, 0x0d, 0xdd };
+  assert(0 == memcmp(fn.selector, totalSupplySelector, 4));
+  assert(4 == abi_encode_call_values(enc, sizeof(enc), &fn, NULL, 0));
+  assert(0 == memcmp(enc, totalSupplySelector, 4));
+  assert(-1 == abi_encode_call_values(enc, sizeof(enc), &fn, transferValues, 2));
+
+  // Arrays and tuples
+  assert(0 < abi_get_signature(sig, sizeof(sig), "f", ex6_abi, ARRAY_SIZE(ex6_abi)));
+  assert(0 == strcmp(sig, "f(string[2],string[],string[1])"));
+  assert(0 < abi_get_signature(sig, sizeof(sig), "f", tupleMulti14_abi, ARRAY_SIZE(tupleMulti14_abi)));
+  assert(0 == strcmp(sig, "f((bytes32[7])[2],bool,bytes32,bytes32[])"));
+  assert(0 < abi_get_signature(sig, sizeof(sig), "marketSellOrders", marketSellOrders_abi, ARRAY_SIZE(marketSellOrders_abi)));
+  assert(0 == strcmp(sig, "marketSellOrders((address,address,address,address,uint256,uint256,uint256,uint256,"
+                          "uint256,uint256,bytes,bytes)[],uint256,bytes[])"));
+  assert(true == abi_compile_function(&fn, "marketSellOrders", marketSellOrders_abi, ARRAY_SIZE(marketSellOrders_abi)));
+  assert(0 == memcmp(fn.selector, marketSellOrders_encoded, 4));
+
+  // fillOrder: the whole call is written in one pass
+  assert(true == abi_compile_function(&fn, "fillOrder", fillOrder_abi, ARRAY_SIZE(fillOrder_abi)));
+  assert(0 == memcmp(fn.selector, fillOrder_encoded, 4));
+  const uint8_t * order[12] = { fillOrder_p0_t0, fillOrder_p0_t1, fillOrder_p0_t2, fillOrder_p0_t3, 
+                                fillOrder_p0_t4, fillOrder_p0_t5, fillOrder_p0_t6, fillOrder_p0_t7, 
+                                fillOrder_p0_t8, fillOrder_p0_t9, fillOrder_p0_t10, fillOrder_p0_t11 };
+  const size_t orderSzs[12] = { 20, 20, 20, 20, 32, 32, 32, 32, 32, 32, 36, 36 };
+  ABIValue_t orderParams[12];
+  for (size_t i = 0; i < 12; i++) {
+    orderParams[i].ptr = order[i];
+    orderParams[i].len = orderSzs[i];
+  }
+  ABIValue_t values[3] = {  { orderParams, 12 }, 
+                            { fillOrder_p1, sizeof(fillOrder_p1) }, 
+                            { fillOrder_p2_0, sizeof(fillOrder_p2_0) } };
+  memset(enc, 0xff, sizeof(enc));
+  assert(sizeof(fillOrder_encoded) == abi_encode_call_values(enc, sizeof(enc), &fn, values, 3));
+  assert(0 == memcmp(enc, fillOrder_encoded, sizeof(fillOrder_encoded)));
+
+  // Packed params, as for `abi_encode`
+  assert(true == abi_compile_function(&fn, "f", ex10_abi, ARRAY_SIZE(ex10_abi)));
+  uint8_t ex10_params[5 * ABI_WORD_SZ];
+  memcpy(ex10_params, ex10_param_00, ABI_WORD_SZ);
+  memcpy(ex10_params + ABI_WORD_SZ, ex10_param_01, ABI_WORD_SZ);
+  memcpy(ex10_params + (2 * ABI_WORD_SZ), ex10_param_02, ABI_WORD_SZ);
+  memcpy(ex10_params + (3 * ABI_WORD_SZ), ex10_param_10, ABI_WORD_SZ);
+  memcpy(ex10_params + (4 * ABI_WORD_SZ), ex10_param_11, ABI_WORD_SZ);
+  size_t ex10_offsets[2] = { 0, 3 * ABI_WORD_SZ };
+  assert(4 + sizeof(ex10_encoded) == abi_encode_call(enc, sizeof(enc), &fn, ex10_offsets, ex10_params, sizeof(ex10_params)));
+  assert(0 == memcmp(enc, fn.selector, 4));
+  assert(0 == memcmp(enc + 4, ex10_encoded, sizeof(ex10_encoded)));
+
+  // Tuples nested in tuples have no flattened layout
+  ABI_t nested[3] = { { .type = ABI_TUPLE1 }, { .type = ABI_TUPLE1 }, { .type = ABI_UINT8 } };
+  assert(false == abi_compile_function(&fn, "f", nested, 3));
+  printf("passed.\n\r");
+}
+
+static inline void test_patch_param(void) {
+  printf("Patching params...");
+  static uint8_t buf[4096];
+  static uint8_t enc[4096];
+  static uint8_t out[256];
+  int sz, encSz;
+  ABISelector_t info = { 0 };
+
+  // ex6: f(string[2], string[], string[1]). Each patch must match encoding the new values from scratch.
+  const char * longStr = "a string which no longer fits in a single word";
+  const char * shortStr = "x";
+  ABIValue_t ex6_elems0[2] = { { ex6_param_00, sizeof(ex6_param_00) }, { ex6_param_01, sizeof(ex6_param_01) } };
+  ABIValue_t ex6_elems1[3] = {  { ex6_param_10, sizeof(ex6_param_10) }, 
+                                { ex6_param_11, sizeof(ex6_param_11) }, 
+                                { ex6_param_12, sizeof(ex6_param_12) } };
+  ABIValue_t ex6_elems2[1] = { { ex6_param_20, sizeof(ex6_param_20) } };
+  ABIValue_t ex6_values[3] = { { ex6_elems0, 2 }, { ex6_elems1, 3 }, { ex6_elems2, 1 } };
+  const struct { size_t typeIdx; size_t arrIdx; const char * str; } ex6_patches[5] = {
+    { 0, 0, longStr },    // grows, moving the next element and every following param
+    { 1, 1, shortStr },   // shrinks in a variable size array
+    { 2, 0, "" },         // the last value, so no offsets follow it
+    { 1, 2, "abc" },      // same padded size: nothing moves
+    { 0, 1, longStr },
+  };
+  memcpy(buf, ex6_encoded, sizeof(ex6_encoded));
+  sz = sizeof(ex6_encoded);
+  for (size_t i = 0; i < ARRAY_SIZE(ex6_patches); i++) {
+    info.typeIdx = ex6_patches[i].typeIdx;
+    info.arrIdx = ex6_patches[i].arrIdx;
+    ABIValue_t * elem = (ABIValue_t *) ex6_values[info.typeIdx].ptr + info.arrIdx;
+    elem->ptr = ex6_patches[i].str;
+    elem->len = strlen(ex6_patches[i].str);
+    sz = abi_patch_param(buf, sizeof(buf), sz, ex6_abi, ARRAY_SIZE(ex6_abi), info, elem->ptr, elem->len);
+    encSz = abi_encode_values(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), ex6_values, ARRAY_SIZE(ex6_values));
+    assert(sz > 0 && sz == encSz);
+    assert(0 == memcmp(buf, enc, sz));
+    assert((int) elem->len == abi_decode_param(out, sizeof(out), ex6_abi, ARRAY_SIZE(ex6_abi), info, buf, sz));
+    assert(0 == memcmp(out, elem->ptr, elem->len));
+  }
+
+  // ex10: f(uint[3], uint[]). Elements of elementary arrays are overwritten in place.
+  uint8_t small = 0x2a;
+  memcpy(buf, ex10_encoded, sizeof(ex10_encoded));
+  info.typeIdx = 0;
+  info.arrIdx = 2;
+  assert((int) sizeof(ex10_encoded) == 
+         abi_patch_param(buf, sizeof(ex10_encoded), sizeof(ex10_encoded), ex10_abi, ARRAY_SIZE(ex10_abi), info, &small, 1));
+  info.typeIdx = 1;
+  info.arrIdx = 1;
+  assert((int) sizeof(ex10_encoded) == 
+         abi_patch_param(buf, sizeof(ex10_encoded), sizeof(ex10_encoded), ex10_abi, ARRAY_SIZE(ex10_abi), info, &small, 1));
+  // Words 2 and 6 hold the patched elements
+  for (size_t i = 0; i < sizeof(ex10_encoded); i++) {
+    size_t word = i / ABI_WORD_SZ;
+    if (word != 2 && word != 6)
+      assert(buf[i] == ex10_encoded[i]);
+    else
+      assert(buf[i] == ((i % ABI_WORD_SZ == ABI_WORD_SZ - 1) ? small : 0));
+  }
+  info.arrIdx = 2;
+  assert(-1 == abi_patch_param(buf, sizeof(buf), sizeof(ex10_encoded), ex10_abi, ARRAY_SIZE(ex10_abi), info, &small, 1));
+  info.arrIdx = 0;
+  assert(-1 == abi_patch_param(buf, sizeof(buf), sizeof(ex10_encoded), ex10_abi, ARRAY_SIZE(ex10_abi), info, buf, 33));
+
+  // fillOrder: f((address,...,bytes,bytes), uint256, bytes). Patch the signature after the tuple's data.
+  const uint8_t * in = fillOrder_encoded + 4;
+  size_t inSz = sizeof(fillOrder_encoded) - 4;
+  uint8_t sig[100];
+  memset(sig, 0x5a, sizeof(sig));
+  memcpy(buf, in, inSz);
+  info.typeIdx = 2;
+  info.arrIdx = 0;
+  // The buffer must have room for the grown payload, and it is left untouched if not
+  assert(-1 == abi_patch_param(buf, inSz, inSz, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, sig, sizeof(sig)));
+  assert(0 == memcmp(buf, in, inSz));
+  sz = abi_patch_param(buf, sizeof(buf), inSz, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, sig, sizeof(sig));
+  assert(sz == (int) inSz + ABI_WORD_SZ);
+  assert(true == abi_is_canonical_payload(fillOrder_abi, ARRAY_SIZE(fillOrder_abi), buf, sz));
+  assert((int) sizeof(sig) == abi_decode_param(out, sizeof(out), fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, buf, sz));
+  assert(0 == memcmp(out, sig, sizeof(sig)));
+  ABISelector_t tupleInfo = { 0 };
+  ABISelector_t paramInfo = { .typeIdx = 11 };
+  assert((int) sizeof(fillOrder_p0_t11) == abi_decode_tuple_param(out, sizeof(out), fillOrder_abi, ARRAY_SIZE(fillOrder_abi), 
+                                                                   tupleInfo, paramInfo, buf, sz));
+  assert(0 == memcmp(out, fillOrder_p0_t11, sizeof(fillOrder_p0_t11)));
+  // A new fill amount, then the original signature, which restores the original payload
+  uint8_t amount[8] = { 0, 0, 0, 0, 0, 0, 0x12, 0x34 };
+  info.typeIdx = 1;
+  assert(sz == abi_patch_param(buf, sizeof(buf), sz, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, amount, sizeof(amount)));
+  assert(0x12 == buf[(2 * ABI_WORD_SZ) - 2] && 0x34 == buf[(2 * ABI_WORD_SZ) - 1]);
+  assert(sz == abi_patch_param(buf, sizeof(buf), sz, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, 
+                               fillOrder_p1, sizeof(fillOrder_p1)));
+  info.typeIdx = 2;
+  sz = abi_patch_param(buf, sizeof(buf), sz, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, 
+                       fillOrder_p2_0, sizeof(fillOrder_p2_0));
+  assert(sz == (int) inSz);
+  assert(0 == memcmp(buf, in, inSz));
+
+  // A value larger than the whole buffer is rejected without writing anything
+  static uint8_t big[200];
+  memset(big, 0x5a, sizeof(big));
+  memcpy(buf, in, inSz);
+  info.typeIdx = 2;
+  assert(-1 == abi_patch_param(buf, inSz, inSz, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, big, sizeof(big)));
+  assert(0 == memcmp(buf, in, inSz));
+  ABI_t str_abi[1] = { { .type = ABI_STRING } };
+  uint8_t strEnc[3 * ABI_WORD_SZ] = { 0 };
+  strEnc[ABI_WORD_SZ - 1] = ABI_WORD_SZ;
+  strEnc[(2 * ABI_WORD_SZ) - 1] = 2;
+  strEnc[2 * ABI_WORD_SZ] = 'h';
+  strEnc[(2 * ABI_WORD_SZ) + 1] = 'i';
+  uint8_t * strBuf = malloc(sizeof(strEnc));
+  assert(strBuf != NULL);
+  memcpy(strBuf, strEnc, sizeof(strEnc));
+  info.typeIdx = 0;
+  assert(-1 == abi_patch_param(strBuf, sizeof(strEnc), sizeof(strEnc), str_abi, 1, info, big, sizeof(big)));
+  assert(0 == memcmp(strBuf, strEnc, sizeof(strEnc)));
+  free(strBuf);
+
+  // Params of tuples (and tuples themselves) cannot be patched
+  info.typeIdx = 0;
+  assert(-1 == abi_patch_param(buf, sizeof(buf), sz, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, sig, 20));
+  info.typeIdx = 3;
+  assert(-1 == abi_patch_param(buf, sizeof(buf), sz, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, sig, 20));
+  // Truncated payloads are rejected
+  info.typeIdx = 2;
+  assert(-1 == abi_patch_param(buf, sizeof(buf), sz - 1, fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, sig, 20));
+  assert(0 == memcmp(buf, in, inSz));
+  printf("passed.\n\r");
+}
+
+static inline void test_packed(void) {
+  printf("Packed encoding...");
+  uint8_t enc[256];
+  uint8_t out[64];
+  ABISelector_t info = { 0 };
+
+  // The example from the Solidity docs: 
+  // abi.encodePacked(int16(-1), bytes1(0x42), uint16(0x03), string("Hello, world!"))
+  ABI_t docs_abi[4] = { { .type = ABI_INT16 }, { .type = ABI_BYTES1 }, { .type = ABI_UINT16 }, { .type = ABI_STRING } };
+  const uint8_t docs_encoded[18] = {  0xff, 0xff, 0x42, 0x00, 0x03, 0x48, 0x65, 0x6c, 0x6c, 0x6f, 
+                                      0x2c, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x21 };
+  const char * hello = "Hello, world!";
+  uint8_t minusOne[ABI_WORD_SZ];
+  memset(minusOne, 0xff, sizeof(minusOne));
+  uint8_t b = 0x42, three = 0x03;
+  ABIValue_t docs_values[4] = { { minusOne, 1 }, { &b, 1 }, { &three, 1 }, { hello, strlen(hello) } };
+  assert(18 == abi_encode_packed(enc, sizeof(enc), docs_abi, 4, docs_values, 4));
+  assert(0 == memcmp(enc, docs_encoded, 18));
+  // Signed values may also be given as a whole word, as they are decoded
+  docs_values[0].len = ABI_WORD_SZ;
+  assert(18 == abi_encode_packed(enc, sizeof(enc), docs_abi, 4, docs_values, 4));
+  assert(0 == memcmp(enc, docs_encoded, 18));
+  assert(-1 == abi_encode_packed(enc, 17, docs_abi, 4, docs_values, 4));
+  // ... but the value must fit in the type
+  minusOne[0] = 0x7f;
+  assert(-1 == abi_encode_packed(enc, sizeof(enc), docs_abi, 4, docs_values, 4));
+  minusOne[0] = 0xff;
+
+  // Decode each param back: the string takes the bytes the other params leave
+  assert(ABI_WORD_SZ == abi_decode_packed_param(out, sizeof(out), docs_abi, 4, info, docs_encoded, 18));
+  assert(0 == memcmp(out, minusOne, ABI_WORD_SZ));
+  info.typeIdx = 1;
+  assert(1 == abi_decode_packed_param(out, sizeof(out), docs_abi, 4, info, docs_encoded, 18));
+  assert(b == out[0]);
+  info.typeIdx = 2;
+  assert(2 == abi_decode_packed_param(out, sizeof(out), docs_abi, 4, info, docs_encoded, 18));
+  assert(0 == out[0] && three == out[1]);
+  info.typeIdx = 3;
+  assert((int) strlen(hello) == abi_decode_packed_param(out, sizeof(out), docs_abi, 4, info, docs_encoded, 18));
+  assert(0 == memcmp(out, hello, strlen(hello)));
+  assert(-1 == abi_decode_packed_param(out, 12, docs_abi, 4, info, docs_encoded, 18));
+  assert(-1 == abi_decode_packed_param(out, sizeof(out), docs_abi, 4, info, docs_encoded, 4));
+
+  // f(address, uint256[], bool): array elements are padded words without a length prefix
+  ABI_t arr_abi[3] = { { .type = ABI_ADDRESS }, { .type = ABI_UINT256, .isArray = true }, { .type = ABI_BOOL } };
+  uint8_t t = 1;
+  ABIValue_t elems[2] = { { ex10_param_10, sizeof(ex10_param_10) }, { &three, 1 } };
+  ABIValue_t arr_values[3] = { { fillOrder_p0_t0, sizeof(fillOrder_p0_t0) }, { elems, 2 }, { &t, 1 } };
+  int sz = abi_encode_packed(enc, sizeof(enc), arr_abi, 3, arr_values, 3);
+  assert(sz == 20 + (2 * ABI_WORD_SZ) + 1);
+  assert(0 == memcmp(enc, fillOrder_p0_t0, 20));
+  assert(0 == memcmp(enc + 20, ex10_param_10, ABI_WORD_SZ));
+  assert(three == enc[20 + (2 * ABI_WORD_SZ) - 1]);
+  assert(t == enc[sz - 1]);
+  info.typeIdx = 1;
+  info.arrIdx = 1;
+  assert(ABI_WORD_SZ == abi_decode_packed_param(out, sizeof(out), arr_abi, 3, info, enc, sz));
+  assert(three == out[ABI_WORD_SZ - 1]);
+  info.arrIdx = 2;
+  assert(-1 == abi_decode_packed_param(out, sizeof(out), arr_abi, 3, info, enc, sz));
+  info.typeIdx = 2;
+  info.arrIdx = 0;
+  assert(1 == abi_decode_packed_param(out, sizeof(out), arr_abi, 3, info, enc, sz));
+  assert(t == out[0]);
+  assert(-1 == abi_decode_packed_param(out, sizeof(out), arr_abi, 3, info, enc, sz - 1));
+  arr_abi[1].arraySz = 3;
+  assert(-1 == abi_encode_packed(enc, sizeof(enc), arr_abi, 3, arr_values, 3));
+
+  // Two dynamic params can be encoded, but their boundary is lost
+  ABI_t dyn_abi[2] = { { .type = ABI_BYTES }, { .type = ABI_STRING } };
+  ABIValue_t dyn_values[2] = { { &b, 1 }, { hello, strlen(hello) } };
+  sz = abi_encode_packed(enc, sizeof(enc), dyn_abi, 2, dyn_values, 2);
+  assert(sz == 1 + (int) strlen(hello));
+  assert(b == enc[0] && 0 == memcmp(enc + 1, hello, strlen(hello)));
+  info.typeIdx = 0;
+  assert(-1 == abi_decode_packed_param(out, sizeof(out), dyn_abi, 2, info, enc, sz));
+
+  // Tuples and arrays of dynamic types have no packed encoding
+  assert(-1 == abi_encode_packed(enc, sizeof(enc), ex6_abi, ARRAY_SIZE(ex6_abi), dyn_values, ARRAY_SIZE(ex6_abi)));
+  assert(-1 == abi_decode_packed_param(out, sizeof(out), fillOrder_abi, ARRAY_SIZE(fillOrder_abi), info, enc, sz));
+  printf("passed.\n\r");
+}
+
+static inline void test_walk(uint8_t * out, size_t outSz) {
+  printf("Walk decoding...");
+  ABIItem_t items[16];
+  int n;
+  // Full walk over elementary, dynamic, and array params
+  uint8_t * in = ex3_encoded+4;
+  size_t inSz = sizeof(ex3_encoded) - 4;
+  n = abi_decode_walk(out, outSz, items, ARRAY_SIZE(items), ex3_abi, ARRAY_SIZE(ex3_abi), NULL, in, inSz, 0);
+  assert(n == 5);
+  assert(items[0].typeIdx == 0 && items[0].sz == sizeof(ex3_param_0));
+  assert(0 == memcmp(ex3_param_0, out + items[0].off, sizeof(ex3_param_0)));
+  assert(items[1].typeIdx == 1 && (bool) out[items[1].off] == ex3_param_1);
+  assert(items[2].typeIdx == 2 && items[2].info.arrIdx == 0);
+  assert(0 == memcmp(ex3_param_20, out + items[2].off, sizeof(ex3_param_20)));
+  assert(0 == memcmp(ex3_param_21, out + items[3].off, sizeof(ex3_param_21)));
+  assert(items[4].info.arrIdx == 2);
+  assert(0 == memcmp(ex3_param_22, out + items[4].off, sizeof(ex3_param_22)));
+  memset(out, 0, outSz);
+
+  // Full walk over a variable size tuple array with nested arrays
+  in = tupleVarArray3_encoded;
+  inSz = sizeof(tupleVarArray3_encoded);
+  n = abi_decode_walk(out, outSz, items, ARRAY_SIZE(items), tupleVarArray3_abi, 
+                      ARRAY_SIZE(tupleVarArray3_abi), NULL, in, inSz, 0);
+  assert(n == 8);
+  assert(items[0].isTupleParam && items[0].tupleInfo.arrIdx == 0 && items[0].typeIdx == 2);
+  assert(out[items[2].off] == tupleVarArray3_p0_t0_p0_2[0]);
+  assert(items[3].typeIdx == 3);
+  assert(0 == memcmp(tupleVarArray3_p0_t0_p1, out + items[3].off, sizeof(tupleVarArray3_p0_t0_p1)));
+  assert(items[4].tupleInfo.arrIdx == 1 && items[5].info.arrIdx == 1);
+  assert(0 == memcmp(tupleVarArray3_p0_t1_p1, out + items[6].off, sizeof(tupleVarArray3_p0_t1_p1)));
+  assert(!items[7].isTupleParam && out[items[7].off] == tupleVarArray3_p1[0]);
+  memset(out, 0, outSz);
+
+  // Projection of one root param and one tuple param
+  bool projection[ARRAY_SIZE(fillOrder_abi)] = { 0 };
+  projection[1] = true;
+  projection[7] = true;
+  in = fillOrder_encoded+4;
+  inSz = sizeof(fillOrder_encoded) - 4;
+  n = abi_decode_walk(out, outSz, items, ARRAY_SIZE(items), fillOrder_abi, 
+                      ARRAY_SIZE(fillOrder_abi), projection, in, inSz, 0);
+  assert(n == 2);
+  assert(items[0].typeIdx == 7 && items[0].info.typeIdx == 4 && items[0].sz == sizeof(fillOrder_p0_t4));
+  assert(0 == memcmp(fillOrder_p0_t4, out + items[0].off, sizeof(fillOrder_p0_t4)));
+  assert(items[1].typeIdx == 1 && items[1].sz == sizeof(fillOrder_p1));
+  assert(0 == memcmp(fillOrder_p1, out + items[1].off, sizeof(fillOrder_p1)));
+  // Not enough room for all items
+  assert(abi_decode_walk(out, outSz, items, 1, fillOrder_abi, 
+                         ARRAY_SIZE(fillOrder_abi), projection, in, inSz, 0) == -1);
+  memset(out, 0, outSz);
+
+  // Batch decoding. The second payload is truncated and should be skipped.
+  const void * ins[3] = { ex1_encoded+4, ex1_encoded+4, ex1_encoded+4 };
+  size_t inSzs[3] = { sizeof(ex1_encoded) - 4, ABI_WORD_SZ, sizeof(ex1_encoded) - 4 };
+  int counts[3];
+  bool ex1_projection[ARRAY_SIZE(ex1_abi)] = { false, true };
+  n = abi_decode_batch( out, outSz, items, ARRAY_SIZE(items), ex1_abi, ARRAY_SIZE(ex1_abi), 
+                        ex1_projection, ins, inSzs, ARRAY_SIZE(ins), counts, 0);
+  assert(n == 2);
+  assert(counts[0] == 1 && counts[1] == -1 && counts[2] == 1);
+  assert(items[0].payloadIdx == 0 && items[1].payloadIdx == 2);
+  assert((bool) out[items[1].off] == ex1_param_1);
+  memset(out, 0, outSz);
+  printf("passed.\n\r");
+}
+
+static inline void test_predicate(void) {
+  printf("Predicates...");
+  ABIPredicate_t pred;
+  // function f(address,address[1],address[],bool)
+  uint8_t * in = ex9_encoded;
+  size_t inSz = sizeof(ex9_encoded);
+  uint8_t t = 1;
+  ABICondition_t conds[3] = {
+    { .info = { .typeIdx = 0 }, .cmp = ABI_CMP_EQ, .val = ex9_param_0, .valSz = sizeof(ex9_param_0) },
+    { .info = { .typeIdx = 1 }, .cmp = ABI_CMP_EQ, .val = ex9_param_10, .valSz = sizeof(ex9_param_10) },
+    { .info = { .typeIdx = 3 }, .cmp = ABI_CMP_EQ, .val = &t, .valSz = 1 },
+  };
+  assert(true == abi_compile_predicate(&pred, ex9_abi, ARRAY_SIZE(ex9_abi), conds, ARRAY_SIZE(conds)));
+  assert(pred.conditions[2].off == 3 * ABI_WORD_SZ);
+  assert(true == abi_predicate_matches(&pred, in, inSz));
+  assert(false == abi_predicate_matches(&pred, in, 4 * ABI_WORD_SZ - 1));
+  conds[1].val = ex9_param_20;
+  assert(true == abi_compile_predicate(&pred, ex9_abi, ARRAY_SIZE(ex9_abi), conds, ARRAY_SIZE(conds)));
+  assert(false == abi_predicate_matches(&pred, in, inSz));
+  // Params behind offsets cannot be compiled
+  conds[1].info.typeIdx = 2;
+  assert(false == abi_compile_predicate(&pred, ex9_abi, ARRAY_SIZE(ex9_abi), conds, ARRAY_SIZE(conds)));
+  // Values must fit in the type
+  conds[0].valSz = sizeof(ex9_param_0) + 1;
+  assert(false == abi_compile_predicate(&pred, ex9_abi, ARRAY_SIZE(ex9_abi), conds, 1));
+
+  // Signed comparisons: int8 -1 < 0 < 1
+  uint8_t zero = 0;
+  ABICondition_t signedConds[2] = {
+    { .info = { .typeIdx = 0 }, .cmp = ABI_CMP_LT, .val = &zero, .valSz = 1 },
+    { .info = { .typeIdx = 2 }, .cmp = ABI_CMP_GT, .val = &zero, .valSz = 1 },
+  };
+  assert(true == abi_compile_predicate(&pred, ex14_abi, ARRAY_SIZE(ex14_abi), signedConds, 2));
+  assert(true == abi_predicate_matches(&pred, ex14_encoded, sizeof(ex14_encoded)));
+  signedConds[0].cmp = ABI_CMP_GTE;
+  assert(true == abi_compile_predicate(&pred, ex14_abi, ARRAY_SIZE(ex14_abi), signedConds, 2));
+  assert(false == abi_predicate_matches(&pred, ex14_encoded, sizeof(ex14_encoded)));
+
+  // Batch filtering: function baz(uint32 x, bool y) where x > 69
+  uint8_t bigger[sizeof(ex1_encoded) - 4];
+  memcpy(bigger, ex1_encoded + 4, sizeof(bigger));
+  bigger[ABI_WORD_SZ - 1] = 70;
+  uint8_t threshold[4] = { 0, 0, 0, 69 };
+  ABICondition_t gtCond = { .info = { .typeIdx = 0 }, .cmp = ABI_CMP_GT, .val = threshold, .valSz = 4 };
+  assert(true == abi_compile_predicate(&pred, ex1_abi, ARRAY_SIZE(ex1_abi), &gtCond, 1));
+  const void * ins[10];
+  size_t inSzs[10];
+  for (size_t i = 0; i < ARRAY_SIZE(ins); i++) {
+    ins[i] = (i % 3 == 0) ? bigger : ex1_encoded + 4;
+    inSzs[i] = sizeof(bigger);
+  }
+  inSzs[9] = ABI_WORD_SZ - 1;
+  uint8_t matches[2];
+  assert(abi_filter_batch(matches, sizeof(matches), &pred, ins, inSzs, ARRAY_SIZE(ins)) == 3);
+  assert(matches[0] == 0x49 && matches[1] == 0x00);
+  assert(abi_filter_batch(matches, 1, &pred, ins, inSzs, ARRAY_SIZE(ins)) == -1);
+  printf("passed.\n\r");
+}
+
+// Reference implementation: add a big endian word into a big endian accumulator
+static void add_u256_be(uint8_t * acc, const uint8_t * w) {
+  uint16_t carry = 0;
+  for (int i = ABI_WORD_SZ - 1; i >= 0; i--) {
+    carry += acc[i] + w[i];
+    acc[i] = carry & 0xff;
+    carry >>= 8;
+  }
+}
+
+static inline void test_u256_agg(void) {
+  printf("uint256 aggregation...");
+  uint8_t res[ABI_WORD_SZ];
+  // Sum the fixed size array in ex5 directly out of the payload
+  uint8_t * in = ex5_encoded+4;
+  assert(0 == abi_u256_sum(res, in, ABI_WORD_SZ, 3));
+  assert(res[31] == 0x0b + 0x16 + 0x21 && res[30] == 0);
+  assert(0 == abi_u256_min(res, in, ABI_WORD_SZ, 3));
+  assert(0 == memcmp(res, ex5_param_00, ABI_WORD_SZ));
+  assert(0 == abi_u256_max(res, in, ABI_WORD_SZ, 3));
+  assert(0 == memcmp(res, ex5_param_02, ABI_WORD_SZ));
+  size_t count;
+  assert(0 == abi_u256_count_gt(&count, in, ABI_WORD_SZ, 3, ex5_param_00));
+  assert(2 == count);
+  assert(-1 == abi_u256_count_gt(NULL, in, ABI_WORD_SZ, 3, ex5_param_00));
+  assert(-1 == abi_u256_min(res, in, ABI_WORD_SZ, 0));
+
+  // Strided column with lots of carries between 32-bit chunks
+  static uint8_t words[AGG_NUM_WORDS * AGG_STRIDE];
+  uint8_t expSum[ABI_WORD_SZ] = { 0 };
+  uint8_t expMin[ABI_WORD_SZ], expMax[ABI_WORD_SZ], threshold[ABI_WORD_SZ];
+  uint32_t seed = 12345;
+  for (size_t i = 0; i < sizeof(words); i++) {
+    seed = seed * 1103515245 + 12345;
+    words[i] = (seed >> 16) & 0xff;
+  }
+  memcpy(threshold, words, ABI_WORD_SZ);
+  threshold[0] = 0;
+  threshold[1] = 0x0f;
+  size_t expGt = 0;
+  for (size_t i = 0; i < AGG_NUM_WORDS; i++) {
+    uint8_t * w = words + (i * AGG_STRIDE);
+    // Leave headroom for the sum and make some words all 0xff below the top byte
+    w[0] = 0;
+    w[1] = w[1] & 0x1f;
+    if (i % 7 == 0)
+      memset(w + 2, 0xff, ABI_WORD_SZ - 2);
+    add_u256_be(expSum, w);
+    if (i == 0 || memcmp(w, expMin, ABI_WORD_SZ) < 0)
+      memcpy(expMin, w, ABI_WORD_SZ);
+    if (i == 0 || memcmp(w, expMax, ABI_WORD_SZ) > 0)
+      memcpy(expMax, w, ABI_WORD_SZ);
+    if (memcmp(w, threshold, ABI_WORD_SZ) > 0)
+      expGt++;
+  }
+  assert(0 == abi_u256_sum(res, words, AGG_STRIDE, AGG_NUM_WORDS));
+  assert(0 == memcmp(res, expSum, ABI_WORD_SZ));
+  assert(0 == abi_u256_min(res, words, AGG_STRIDE, AGG_NUM_WORDS));
+  assert(0 == memcmp(res, expMin, ABI_WORD_SZ));
+  assert(0 == abi_u256_max(res, words, AGG_STRIDE, AGG_NUM_WORDS));
+  assert(0 == memcmp(res, expMax, ABI_WORD_SZ));
+  assert(0 == abi_u256_count_gt(&count, words, AGG_STRIDE, AGG_NUM_WORDS, threshold));
+  assert(expGt == count);
+
+  // Overflow is reported
+  uint8_t maxWords[2 * ABI_WORD_SZ];
+  memset(maxWords, 0xff, sizeof(maxWords));
+  assert(0 == abi_u256_sum(res, maxWords, ABI_WORD_SZ, 1));
+  assert(-1 == abi_u256_sum(res, maxWords, ABI_WORD_SZ, 2));
+  printf("passed.\n\r");
+}
+
+// Check the results of decoding the block built in `test_block`
+static void check_block_results(const ABIBlockResult_t * results) {
+  assert(results[0].schemaIdx == 2 && results[0].numItems == 1);
+  assert(0 == memcmp(fillOrder_p1, results[0].out + results[0].items[0].off, sizeof(fillOrder_p1)));
+  assert(results[0].items[0].payloadIdx == 0);
+  assert(results[1].schemaIdx == 0 && results[1].numItems == 2);
+  assert((bool) results[1].out[results[1].items[1].off] == ex1_param_1);
+  assert(results[2].schemaIdx == 1 && results[2].numItems == 5);
+  assert(0 == memcmp(ex3_param_22, results[2].out + results[2].items[4].off, sizeof(ex3_param_22)));
+  assert(results[3].schemaIdx == -1 && results[3].numItems == -1);
+  assert(results[4].schemaIdx == 0 && results[4].numItems == -1);
+  assert(results[5].numItems == 2 && results[5].items[0].payloadIdx == 5);
+  assert(results[6].numItems == 1 && results[6].items[0].payloadIdx == 6);
+  assert(results[7].schemaIdx == -1);
+  assert(results[8].numItems == 5);
+  assert(0 == memcmp(ex3_param_0, results[8].out + results[8].items[0].off, sizeof(ex3_param_0)));
+}
+
+static inline void test_block(void) {
+  printf("Block decoding...");
+  uint8_t addrA[ABI_ADDRESS_SZ] = { 0xaa };
+  uint8_t addrB[ABI_ADDRESS_SZ] = { 0xbb };
+  bool fillOrderProjection[ARRAY_SIZE(fillOrder_abi)] = { 0 };
+  fillOrderProjection[1] = true;
+  ABIBlockSchema_t schemas[3] = {
+    { .types = ex1_abi, .numTypes = ARRAY_SIZE(ex1_abi) },
+    { .types = ex3_abi, .numTypes = ARRAY_SIZE(ex3_abi) },
+    { .types = fillOrder_abi, .numTypes = ARRAY_SIZE(fillOrder_abi), .projection = fillOrderProjection },
+  };
+  memcpy(schemas[0].address, addrA, ABI_ADDRESS_SZ);
+  memcpy(schemas[0].selector, ex1_encoded, ABI_SELECTOR_SZ);
+  memcpy(schemas[1].address, addrA, ABI_ADDRESS_SZ);
+  memcpy(schemas[1].selector, ex3_encoded, ABI_SELECTOR_SZ);
+  memcpy(schemas[2].address, addrB, ABI_ADDRESS_SZ);
+  memcpy(schemas[2].selector, fillOrder_encoded, ABI_SELECTOR_SZ);
+  ABIBlockTx_t txs[9] = {
+    { .to = addrB, .data = fillOrder_encoded, .dataSz = sizeof(fillOrder_encoded) },
+    { .to = addrA, .data = ex1_encoded, .dataSz = sizeof(ex1_encoded) },
+    { .to = addrA, .data = ex3_encoded, .dataSz = sizeof(ex3_encoded) },
+    { .to = addrB, .data = ex1_encoded, .dataSz = sizeof(ex1_encoded) },         // Unknown schema
+    { .to = addrA, .data = ex1_encoded, .dataSz = ABI_WORD_SZ },                 // Malformed
+    { .to = addrA, .data = ex1_encoded, .dataSz = sizeof(ex1_encoded) },
+    { .to = addrB, .data = fillOrder_encoded, .dataSz = sizeof(fillOrder_encoded) },
+    { .to = addrA, .data = ex3_encoded, .dataSz = 2 },                           // No selector
+    { .to = addrA, .data = ex3_encoded, .dataSz = sizeof(ex3_encoded) },
+  };
+  ABIBlockResult_t results[ARRAY_SIZE(txs)];
+  static uint8_t out[4096];
+  ABIItem_t items[64];
+  for (size_t numThreads = 1; numThreads <= 4; numThreads++) {
+    memset(results, 0, sizeof(results));
+    assert(6 == abi_decode_block( results, txs, ARRAY_SIZE(txs), schemas, ARRAY_SIZE(schemas), 
+                                  out, sizeof(out), items, ARRAY_SIZE(items), numThreads));
+    check_block_results(results);
+  }
+  // Any number of threads may be requested, but no more than `ABI_BLOCK_THREADS_MAX` are used
+  static ABIBlockTx_t manyTxs[1024];
+  static ABIBlockResult_t manyResults[ARRAY_SIZE(manyTxs)];
+  static uint8_t manyOut[ARRAY_SIZE(manyTxs) * ABI_WORD_SZ];
+  static ABIItem_t manyItems[4 * ARRAY_SIZE(manyTxs)];
+  for (size_t i = 0; i < ARRAY_SIZE(manyTxs); i++)
+    manyTxs[i] = txs[1];
+  assert((int) ARRAY_SIZE(manyTxs) == abi_decode_block( manyResults, manyTxs, ARRAY_SIZE(manyTxs), 
+                                                        schemas, ARRAY_SIZE(schemas), manyOut, sizeof(manyOut), 
+                                                        manyItems, ARRAY_SIZE(manyItems), SIZE_MAX));
+  assert(manyResults[ARRAY_SIZE(manyTxs) - 1].numItems == 2);
+  // The same block through worker pools, reusing each pool's arenas across blocks
+  for (size_t numWorkers = 1; numWorkers <= 3; numWorkers++) {
+    ABIBlockPool_t * pool = abi_block_pool_create(numWorkers, 4096, 64 * sizeof(ABIItem_t), 
+                                                  ARRAY_SIZE(txs), ARRAY_SIZE(schemas));
+    assert(pool);
+    assert(abi_block_pool_num_pinned(pool) <= numWorkers);
+#ifdef __linux__
+    assert(abi_block_pool_num_pinned(pool) == numWorkers);
+#endif
+    for (size_t i = 0; i < 3; i++) {
+      memset(results, 0, sizeof(results));
+      assert(6 == abi_block_pool_decode(pool, results, txs, ARRAY_SIZE(txs), schemas, ARRAY_SIZE(schemas)));
+      check_block_results(results);
+    }
+    abi_block_pool_destroy(pool);
+  }
+  // More transactions or schemas than the pool was created for
+  ABIBlockPool_t * pool = abi_block_pool_create(1, 4096, 64 * sizeof(ABIItem_t), ARRAY_SIZE(txs) - 1, ARRAY_SIZE(schemas));
+  assert(pool);
+  assert(-1 == abi_block_pool_decode(pool, results, txs, ARRAY_SIZE(txs), schemas, ARRAY_SIZE(schemas)));
+  abi_block_pool_destroy(pool);
+  pool = abi_block_pool_create(1, 4096, 64 * sizeof(ABIItem_t), ARRAY_SIZE(txs), ARRAY_SIZE(schemas) - 1);
+  assert(pool);
+  assert(-1 == abi_block_pool_decode(pool, results, txs, ARRAY_SIZE(txs), schemas, ARRAY_SIZE(schemas)));
+  // Without the fillOrder schema
+  assert(4 == abi_block_pool_decode(pool, results, txs, ARRAY_SIZE(txs), schemas, ARRAY_SIZE(schemas) - 1));
+  abi_block_pool_destroy(pool);
+  // Sizes which would overflow
+  assert(NULL == abi_block_pool_create(SIZE_MAX, 4096, 64 * sizeof(ABIItem_t), ARRAY_SIZE(txs), ARRAY_SIZE(schemas)));
+  assert(NULL == abi_block_pool_create(1, 4096, 64 * sizeof(ABIItem_t), ARRAY_SIZE(txs), SIZE_MAX));
+  printf("passed.\n\r");
+}
+
+static inline void test_array(uint8_t * out, size_t outSz) {
+  printf("Bulk array decoding...");
+  // address[1] and address[]
+  ABISelector_t info = { .typeIdx = 1 };
+  assert(1 == abi_decode_array(out, outSz, ex9_abi, ARRAY_SIZE(ex9_abi), info, ex9_encoded, sizeof(ex9_encoded), ABI_DECODE_STRICT));
+  assert(0 == memcmp(out, ex9_param_10, sizeof(ex9_param_10)));
+  info.typeIdx = 2;
+  assert(2 == abi_decode_array(out, outSz, ex9_abi, ARRAY_SIZE(ex9_abi), info, ex9_encoded, sizeof(ex9_encoded), ABI_DECODE_STRICT));
+  assert(0 == memcmp(out, ex9_param_20, sizeof(ex9_param_20)));
+  assert(0 == memcmp(out + 20, ex9_param_21, sizeof(ex9_param_21)));
+  // Not enough space for both addresses
+  assert(-1 == abi_decode_array(out, 39, ex9_abi, ARRAY_SIZE(ex9_abi), info, ex9_encoded, sizeof(ex9_encoded), 0));
+  // Not an array
+  info.typeIdx = 0;
+  assert(-1 == abi_decode_array(out, outSz, ex9_abi, ARRAY_SIZE(ex9_abi), info, ex9_encoded, sizeof(ex9_encoded), 0));
+  // Other elementary types are packed at their decoded size
+  info.typeIdx = 1;
+  assert(2 == abi_decode_array(out, outSz, ex4_abi, ARRAY_SIZE(ex4_abi), info, ex4_encoded + 4, sizeof(ex4_encoded) - 4, 0));
+  assert(ex4_param_10 == get_u32_be(out, 0));
+  assert(ex4_param_11 == get_u32_be(out, 4));
+  info.typeIdx = 2;
+  assert(3 == abi_decode_array(out, outSz, ex3_abi, ARRAY_SIZE(ex3_abi), info, ex3_encoded + 4, sizeof(ex3_encoded) - 4, 0));
+  assert(0 == memcmp(out + 64, ex3_param_22, sizeof(ex3_param_22)));
+
+  // A larger address[] must match element-by-element decoding
+  ABI_t addrs_abi[1] = { { .type = ABI_ADDRESS, .isArray = true } };
+  ABISelector_t addrsInfo = { .typeIdx = 0 };
+  const size_t numAddrs = 37;
+  uint8_t in[ABI_WORD_SZ * (2 + 37)] = { 0 };
+  in[ABI_WORD_SZ - 1] = ABI_WORD_SZ;
+  in[(2 * ABI_WORD_SZ) - 1] = numAddrs;
+  for (size_t i = 0; i < numAddrs; i++)
+    for (size_t j = 12; j < ABI_WORD_SZ; j++)
+      in[(2 + i) * ABI_WORD_SZ + j] = (uint8_t) (i * 31 + j);
+  uint8_t packed[20 * 37];
+  assert((int) numAddrs == abi_decode_array(packed, sizeof(packed), addrs_abi, 1, addrsInfo, in, sizeof(in), ABI_DECODE_STRICT));
+  for (size_t i = 0; i < numAddrs; i++) {
+    ABISelector_t elem = { .typeIdx = 0, .arrIdx = i };
+    assert(20 == abi_decode_param(out, outSz, addrs_abi, 1, elem, in, sizeof(in)));
+    assert(0 == memcmp(out, packed + (20 * i), 20));
+  }
+  // Dirty padding is only rejected in strict mode
+  in[(2 + 20) * ABI_WORD_SZ + 3] = 1;
+  assert(-1 == abi_decode_array(packed, sizeof(packed), addrs_abi, 1, addrsInfo, in, sizeof(in), ABI_DECODE_STRICT));
+  assert((int) numAddrs == abi_decode_array(packed, sizeof(packed), addrs_abi, 1, addrsInfo, in, sizeof(in), 0));
+  in[(2 + 20) * ABI_WORD_SZ + 3] = 0;
+  in[(2 + numAddrs - 1) * ABI_WORD_SZ + 11] = 1;
+  assert(-1 == abi_decode_array(packed, sizeof(packed), addrs_abi, 1, addrsInfo, in, sizeof(in), ABI_DECODE_STRICT));
+  // Array size runs past the end of the payload
+  in[(2 * ABI_WORD_SZ) - 1] = numAddrs + 1;
+  assert(-1 == abi_decode_array(packed, sizeof(packed), addrs_abi, 1, addrsInfo, in, sizeof(in), 0));
+  printf("passed.\n\r");
+}
+
+static inline void test_strict(uint8_t * out, size_t outSz) {
+  printf("Strict decoding...");
+  ABIItem_t items[32];
+  uint8_t in[512];
+  // Payloads from a conforming encoder are canonical
+  assert(abi_is_canonical_payload(ex1_abi, ARRAY_SIZE(ex1_abi), ex1_encoded + 4, sizeof(ex1_encoded) - 4));
+  assert(abi_is_canonical_payload(ex3_abi, ARRAY_SIZE(ex3_abi), ex3_encoded + 4, sizeof(ex3_encoded) - 4));
+  assert(abi_is_canonical_payload(ex4_abi, ARRAY_SIZE(ex4_abi), ex4_encoded + 4, sizeof(ex4_encoded) - 4));
+  assert(abi_is_canonical_payload(ex9_abi, ARRAY_SIZE(ex9_abi), ex9_encoded, sizeof(ex9_encoded)));
+  assert(abi_is_canonical_payload(ex13_abi, ARRAY_SIZE(ex13_abi), ex13_encoded, sizeof(ex13_encoded)));
+  assert(abi_is_canonical_payload(fillOrder_abi, ARRAY_SIZE(fillOrder_abi), fillOrder_encoded + 4, sizeof(fillOrder_encoded) - 4));
+  assert(abi_is_canonical_payload(tupleVarArray3_abi, ARRAY_SIZE(tupleVarArray3_abi), tupleVarArray3_encoded, sizeof(tupleVarArray3_encoded)));
+  assert(abi_is_canonical_payload(tupleMulti5_abi, ARRAY_SIZE(tupleMulti5_abi), tupleMulti5_encoded, sizeof(tupleMulti5_encoded)));
+
+  // f(bytes,bool,uint[]): bool, bytes data, and bytes size words
+  size_t inSz = sizeof(ex3_encoded) - 4;
+  size_t badOffs[] = { 
+    ABI_WORD_SZ + 30,                 // Bool padding
+    (2 * ABI_WORD_SZ) - 1,            // Bool value of 3
+    (3 * ABI_WORD_SZ),                // Upper bytes of the bytes size
+    (4 * ABI_WORD_SZ) + 10,           // Right-padding of the bytes data
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(badOffs); i++) {
+    memcpy(in, ex3_encoded + 4, inSz);
+    in[badOffs[i]] |= 0x02;
+    assert(!abi_is_canonical_payload(ex3_abi, ARRAY_SIZE(ex3_abi), in, inSz));
+    assert(-1 == abi_decode_walk(out, outSz, items, ARRAY_SIZE(items), ex3_abi, ARRAY_SIZE(ex3_abi), 
+                                 NULL, in, inSz, ABI_DECODE_STRICT));
+    assert(5 == abi_decode_walk(out, outSz, items, ARRAY_SIZE(items), ex3_abi, ARRAY_SIZE(ex3_abi), 
+                                NULL, in, inSz, ABI_DECODE_DEFAULT));
+  }
+  // Untouched params are not checked
+  bool projection[ARRAY_SIZE(ex3_abi)] = { false, false, true };
+  assert(3 == abi_decode_walk(out, outSz, items, ARRAY_SIZE(items), ex3_abi, ARRAY_SIZE(ex3_abi), 
+                              projection, in, inSz, ABI_DECODE_STRICT));
+
+  // f(uint,uint32[],bytes10,bytes): bytesN right-padding and uint32 array elements
+  inSz = sizeof(ex4_encoded) - 4;
+  memcpy(in, ex4_encoded + 4, inSz);
+  in[(2 * ABI_WORD_SZ) + 10] = 1;
+  assert(!abi_is_canonical_payload(ex4_abi, ARRAY_SIZE(ex4_abi), in, inSz));
+  memcpy(in, ex4_encoded + 4, inSz);
+  size_t arrOff = in[(2 * ABI_WORD_SZ) - 1];
+  in[arrOff + (2 * ABI_WORD_SZ) + 27] = 1;
+  assert(!abi_is_canonical_payload(ex4_abi, ARRAY_SIZE(ex4_abi), in, inSz));
+  ABISelector_t info = { .typeIdx = 1 };
+  assert(-1 == abi_decode_array(out, outSz, ex4_abi, ARRAY_SIZE(ex4_abi), info, in, inSz, ABI_DECODE_STRICT));
+  assert(2 == abi_decode_array(out, outSz, ex4_abi, ARRAY_SIZE(ex4_abi), info, in, inSz, ABI_DECODE_DEFAULT));
+
+  // Signed integers must be sign extended
+  ABI_t int8_abi[1] = { { .type = ABI_INT8 } };
+  memset(in, 0xff, ABI_WORD_SZ);
+  in[ABI_WORD_SZ - 1] = 0x80;
+  assert(abi_is_canonical_payload(int8_abi, 1, in, ABI_WORD_SZ));
+  in[ABI_WORD_SZ - 1] = 0x7f;
+  assert(!abi_is_canonical_payload(int8_abi, 1, in, ABI_WORD_SZ));
+  memset(in, 0, ABI_WORD_SZ);
+  assert(abi_is_canonical_payload(int8_abi, 1, in, ABI_WORD_SZ));
+  in[ABI_WORD_SZ - 1] = 0x80;
+  assert(!abi_is_canonical_payload(int8_abi, 1, in, ABI_WORD_SZ));
+  printf("passed.\n\r");
+}
+
+static inline void test_native_endian(uint8_t * out, size_t outSz) {
+  printf("Native endian decoding...");
+  ABIItem_t items[16];
+  // uint32[] elements are written as uint32_t
+  ABISelector_t info = { .typeIdx = 1 };
+  assert(2 == abi_decode_array(out, outSz, ex4_abi, ARRAY_SIZE(ex4_abi), info, ex4_encoded + 4, 
+                               sizeof(ex4_encoded) - 4, ABI_DECODE_NATIVE_ENDIAN));
+  uint32_t u32s[2];
+  memcpy(u32s, out, sizeof(u32s));
+  assert(u32s[0] == ex4_param_10 && u32s[1] == ex4_param_11);
+  // Walking f(bytes,bool,uint[]) only swaps the uint[] elements
+  int n = abi_decode_walk(out, outSz, items, ARRAY_SIZE(items), ex3_abi, ARRAY_SIZE(ex3_abi), NULL, 
+                          ex3_encoded + 4, sizeof(ex3_encoded) - 4, ABI_DECODE_NATIVE_ENDIAN);
+  assert(n == 5);
+  assert(0 == memcmp(ex3_param_0, out + items[0].off, sizeof(ex3_param_0)));
+  assert((bool) out[items[1].off] == ex3_param_1);
+  for (size_t i = 0; i < 3; i++) {
+    assert(items[2 + i].sz == ABI_WORD_SZ);
+    for (size_t j = 0; j < ABI_WORD_SZ; j++)
+      assert(out[items[2 + i].off + j] == (j == 0 ? i + 1 : 0));
+  }
+
+  // Larger arrays of every width must match swapped element-by-element decoding
+  ABIAtomic_t widths[] = { ABI_UINT8, ABI_UINT24, ABI_UINT64, ABI_UINT128, ABI_UINT256, ABI_INT16 };
+  const size_t numElems = 45;
+  uint8_t in[ABI_WORD_SZ * (2 + 45)] = { 0 };
+  in[ABI_WORD_SZ - 1] = ABI_WORD_SZ;
+  in[(2 * ABI_WORD_SZ) - 1] = numElems;
+  for (size_t i = 0; i < numElems * ABI_WORD_SZ; i++)
+    in[(2 * ABI_WORD_SZ) + i] = (uint8_t) (i * 7 + 3);
+  uint8_t swapped[ABI_WORD_SZ * 45];
+  uint8_t elem[ABI_WORD_SZ];
+  for (size_t t = 0; t < ARRAY_SIZE(widths); t++) {
+    ABI_t arr_abi[1] = { { .type = widths[t], .isArray = true } };
+    ABISelector_t arrInfo = { .typeIdx = 0 };
+    assert((int) numElems == abi_decode_array(swapped, sizeof(swapped), arr_abi, 1, arrInfo, in, sizeof(in), 
+                                              ABI_DECODE_NATIVE_ENDIAN));
+    for (size_t i = 0; i < numElems; i++) {
+      ABISelector_t elemInfo = { .typeIdx = 0, .arrIdx = i };
+      int sz = abi_decode_param(elem, sizeof(elem), arr_abi, 1, elemInfo, in, sizeof(in));
+      assert(sz > 0);
+      for (int j = 0; j < sz; j++)
+        assert(swapped[(i * sz) + j] == elem[sz - 1 - j]);
+    }
+  }
+  printf("passed.\n\r");
+}
+
+static inline void test_bitset(uint8_t * out, size_t outSz) {
+  printf("Bool bitsets...");
+  // bool[] nested in each item of a tuple array
+  ABISelector_t tupleInfo = { .typeIdx = 0, .arrIdx = 0 };
+  ABISelector_t paramInfo = { .typeIdx = 0 };
+  memset(out, 0xff, 8);
+  assert(3 == abi_decode_tuple_array( out, outSz, tupleVarArray3_abi, ARRAY_SIZE(tupleVarArray3_abi), tupleInfo,
+                                      paramInfo, tupleVarArray3_encoded, sizeof(tupleVarArray3_encoded), ABI_DECODE_BITSET));
+  assert(out[0] == (tupleVarArray3_p0_t0_p0_0[0] | (tupleVarArray3_p0_t0_p0_1[0] << 1) | (tupleVarArray3_p0_t0_p0_2[0] << 2)));
+  tupleInfo.arrIdx = 1;
+  assert(2 == abi_decode_tuple_array( out, outSz, tupleVarArray3_abi, ARRAY_SIZE(tupleVarArray3_abi), tupleInfo,
+                                      paramInfo, tupleVarArray3_encoded, sizeof(tupleVarArray3_encoded), ABI_DECODE_BITSET));
+  assert(out[0] == 0);
+  // Without the flag, bools are one byte each
+  tupleInfo.arrIdx = 0;
+  assert(3 == abi_decode_tuple_array( out, outSz, tupleVarArray3_abi, ARRAY_SIZE(tupleVarArray3_abi), tupleInfo,
+                                      paramInfo, tupleVarArray3_encoded, sizeof(tupleVarArray3_encoded), 0));
+  assert(out[0] == tupleVarArray3_p0_t0_p0_0[0] && out[2] == tupleVarArray3_p0_t0_p0_2[0]);
+  // Tuple items past the end of the array
+  int numItems = abi_get_array_sz(tupleVarArray3_abi, ARRAY_SIZE(tupleVarArray3_abi), tupleInfo, 
+                                  tupleVarArray3_encoded, sizeof(tupleVarArray3_encoded));
+  assert(numItems > 1);
+  tupleInfo.arrIdx = numItems;
+  assert(-1 == abi_decode_tuple_array(out, outSz, tupleVarArray3_abi, ARRAY_SIZE(tupleVarArray3_abi), tupleInfo,
+                                      paramInfo, tupleVarArray3_encoded, sizeof(tupleVarArray3_encoded), 0));
+  tupleInfo.arrIdx = 0;
+  assert(-1 == abi_decode_tuple_array(out, outSz, tupleVarArray3_abi, ARRAY_SIZE(tupleVarArray3_abi), tupleInfo,
+                                      paramInfo, tupleVarArray3_encoded, 16, 0));
+
+  // A larger bool[] must match element-by-element decoding
+  ABI_t bools_abi[1] = { { .type = ABI_BOOL, .isArray = true } };
+  ABISelector_t info = { .typeIdx = 0 };
+  const size_t numBools = 77;
+  uint8_t in[ABI_WORD_SZ * (2 + 77)] = { 0 };
+  in[ABI_WORD_SZ - 1] = ABI_WORD_SZ;
+  in[(2 * ABI_WORD_SZ) - 1] = numBools;
+  for (size_t i = 0; i < numBools; i++)
+    in[(3 + i) * ABI_WORD_SZ - 1] = ((i * 5) % 3) == 1;
+  uint8_t bits[10];
+  assert(-1 == abi_decode_array(bits, 9, bools_abi, 1, info, in, sizeof(in), ABI_DECODE_BITSET));
+  assert((int) numBools == abi_decode_array(bits, sizeof(bits), bools_abi, 1, info, in, sizeof(in), ABI_DECODE_BITSET));
+  for (size_t i = 0; i < numBools; i++) {
+    ABISelector_t elem = { .typeIdx = 0, .arrIdx = i };
+    assert(1 == abi_decode_param(out, outSz, bools_abi, 1, elem, in, sizeof(in)));
+    assert(((bits[i / 8] >> (i % 8)) & 1) == out[0]);
+  }
+  // Bools other than 0 or 1 are rejected in vectorized and tail words
+  size_t badOffs[] = { (3 * ABI_WORD_SZ) - 1, (10 * ABI_WORD_SZ), (3 + 76) * ABI_WORD_SZ - 2 };
+  for (size_t i = 0; i < ARRAY_SIZE(badOffs); i++) {
+    uint8_t orig = in[badOffs[i]];
+    in[badOffs[i]] = 2;
+    assert(-1 == abi_decode_array(bits, sizeof(bits), bools_abi, 1, info, in, sizeof(in), ABI_DECODE_BITSET));
+    in[badOffs[i]] = orig;
+  }
+  printf("passed.\n\r");
+}
+
+static inline void test_uint_array(uint8_t * out, size_t outSz) {
+  printf("Narrowing array decoding...");
+  // uint32[] into native integers of every width
+  ABISelector_t info = { .typeIdx = 1 };
+  uint8_t * in = ex4_encoded + 4;
+  size_t inSz = sizeof(ex4_encoded) - 4;
+  uint64_t u64s[2];
+  assert(2 == abi_decode_uint_array(u64s, sizeof(u64s), 8, ex4_abi, ARRAY_SIZE(ex4_abi), info, in, inSz));
+  assert(u64s[0] == ex4_param_10 && u64s[1] == ex4_param_11);
+  uint16_t u16s[2];
+  assert(2 == abi_decode_uint_array(u16s, sizeof(u16s), 2, ex4_abi, ARRAY_SIZE(ex4_abi), info, in, inSz));
+  assert(u16s[0] == ex4_param_10 && u16s[1] == ex4_param_11);
+  // 1929 does not fit in a uint8_t
+  uint8_t u8s[2];
+  assert(-1 == abi_decode_uint_array(u8s, sizeof(u8s), 1, ex4_abi, ARRAY_SIZE(ex4_abi), info, in, inSz));
+  // Not enough room, bad widths, and non-uint arrays
+  assert(-1 == abi_decode_uint_array(u64s, sizeof(u64s) - 1, 8, ex4_abi, ARRAY_SIZE(ex4_abi), info, in, inSz));
+  assert(-1 == abi_decode_uint_array(u64s, sizeof(u64s), 3, ex4_abi, ARRAY_SIZE(ex4_abi), info, in, inSz));
+  info.typeIdx = 2;
+  assert(-1 == abi_decode_uint_array(u64s, sizeof(u64s), 8, ex9_abi, ARRAY_SIZE(ex9_abi), info, ex9_encoded, sizeof(ex9_encoded)));
+  // uint[3] and uint[] are narrowed from 256 bits
+  uint32_t u32s[3];
+  info.typeIdx = 0;
+  assert(3 == abi_decode_uint_array(u32s, sizeof(u32s), 4, ex10_abi, ARRAY_SIZE(ex10_abi), info, ex10_encoded, sizeof(ex10_encoded)));
+  for (size_t i = 0; i < 3; i++) {
+    ABISelector_t elem = { .typeIdx = 0, .arrIdx = i };
+    assert(ABI_WORD_SZ == abi_decode_param(out, outSz, ex10_abi, ARRAY_SIZE(ex10_abi), elem, ex10_encoded, sizeof(ex10_encoded)));
+    assert(u32s[i] == get_u32_be(out, ABI_WORD_SZ - 4));
+  }
+
+  // A larger uint256[], with an overflow in vectorized and tail words
+  ABI_t uints_abi[1] = { { .type = ABI_UINT256, .isArray = true } };
+  ABISelector_t uintsInfo = { .typeIdx = 0 };
+  const size_t numUints = 50;
+  uint8_t uints[ABI_WORD_SZ * (2 + 50)] = { 0 };
+  uints[ABI_WORD_SZ - 1] = ABI_WORD_SZ;
+  uints[(2 * ABI_WORD_SZ) - 1] = numUints;
+  for (size_t i = 0; i < numUints; i++)
+    for (size_t j = 0; j < 8; j++)
+      uints[(3 + i) * ABI_WORD_SZ - 1 - j] = (uint8_t) (i * 13 + j);
+  uint64_t wide[50];
+  assert((int) numUints == abi_decode_uint_array(wide, sizeof(wide), 8, uints_abi, 1, uintsInfo, uints, sizeof(uints)));
+  for (size_t i = 0; i < numUints; i++) {
+    uint64_t expected = 0;
+    for (size_t j = 0; j < 8; j++)
+      expected |= (uint64_t) (uint8_t) (i * 13 + j) << (8 * j);
+    assert(wide[i] == expected);
+  }
+  size_t badOffs[] = { (2 * ABI_WORD_SZ), (20 * ABI_WORD_SZ) + 23, (2 + 49) * ABI_WORD_SZ + 17 };
+  for (size_t i = 0; i < ARRAY_SIZE(badOffs); i++) {
+    uints[badOffs[i]] = 1;
+    assert(-1 == abi_decode_uint_array(wide, sizeof(wide), 8, uints_abi, 1, uintsInfo, uints, sizeof(uints)));
+    uints[badOffs[i]] = 0;
+  }
+  printf("passed.\n\r");
+}
+
+// Write `in` as a 0x-prefixed hex string. Returns the number of characters written.
+static size_t to_hex(char * hex, const uint8_t * in, size_t inSz, bool upper) {
+  const char * digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  hex[0] = '0';
+  hex[1] = 'x';
+  for (size_t i = 0; i < inSz; i++) {
+    hex[2 + (2 * i)] = digits[in[i] >> 4];
+    hex[3 + (2 * i)] = digits[in[i] & 0xf];
+  }
+  return 2 + (2 * inSz);
+}
+
+static inline void test_hex_decode(uint8_t * out, size_t outSz) {
+  printf("Hex decoding...");
+  static char hex[2 + (2 * sizeof(fillOrder_encoded))];
+  static uint8_t scratch[sizeof(fillOrder_encoded)];
+  // Round trip payloads of different lengths, with and without the prefix, in both cases
+  size_t hexSz = to_hex(hex, fillOrder_encoded, sizeof(fillOrder_encoded), false);
+  assert((int) sizeof(fillOrder_encoded) == abi_hex_decode(scratch, sizeof(scratch), hex, hexSz));
+  assert(0 == memcmp(scratch, fillOrder_encoded, sizeof(fillOrder_encoded)));
+  hexSz = to_hex(hex, fillOrder_encoded, sizeof(fillOrder_encoded), true);
+  memset(scratch, 0, sizeof(scratch));
+  assert((int) sizeof(fillOrder_encoded) == abi_hex_decode(scratch, sizeof(scratch), hex + 2, hexSz - 2));
+  assert(0 == memcmp(scratch, fillOrder_encoded, sizeof(fillOrder_encoded)));
+  for (size_t sz = 0; sz < 70; sz++) {
+    hexSz = to_hex(hex, fillOrder_encoded + sz, sz, sz % 2);
+    memset(scratch, 0, sizeof(scratch));
+    assert((int) sz == abi_hex_decode(scratch, sizeof(scratch), hex, hexSz));
+    assert(0 == memcmp(scratch, fillOrder_encoded + sz, sz));
+  }
+  // Odd number of digits, no room, and bad characters in vectorized and tail digits
+  hexSz = to_hex(hex, fillOrder_encoded, 100, false);
+  assert(-1 == abi_hex_decode(scratch, sizeof(scratch), hex, hexSz - 1));
+  assert(-1 == abi_hex_decode(scratch, 99, hex, hexSz));
+  const char badChars[] = { 'g', 'G', ':', '/', '@', '`', ' ', (char) 0x80 };
+  size_t badOffs[] = { 2, 37, 65, 130, hexSz - 1 };
+  for (size_t i = 0; i < ARRAY_SIZE(badOffs); i++) {
+    for (size_t j = 0; j < ARRAY_SIZE(badChars); j++) {
+      char orig = hex[badOffs[i]];
+      hex[badOffs[i]] = badChars[j];
+      assert(-1 == abi_hex_decode(scratch, sizeof(scratch), hex, hexSz));
+      hex[badOffs[i]] = orig;
+    }
+  }
+
+  // Decode params straight from hex
+  hexSz = to_hex(hex, ex3_encoded + 4, sizeof(ex3_encoded) - 4, false);
+  ABISelector_t info = { .typeIdx = 0 };
+  assert((int) sizeof(ex3_param_0) == abi_decode_param_hex( out, outSz, ex3_abi, ARRAY_SIZE(ex3_abi), info, 
+                                                            hex, hexSz, scratch, sizeof(scratch)));
+  assert(0 == memcmp(out, ex3_param_0, sizeof(ex3_param_0)));
+  assert(-1 == abi_decode_param_hex(out, outSz, ex3_abi, ARRAY_SIZE(ex3_abi), info, hex, hexSz, scratch, 10));
+
+  // Batch decoding from hex. The second payload has a bad character and should be skipped.
+  static char hex1[2 + (2 * sizeof(ex1_encoded))];
+  static char hex2[2 + (2 * sizeof(ex1_encoded))];
+  size_t hexSzs[3];
+  hexSzs[0] = to_hex(hex, ex1_encoded + 4, sizeof(ex1_encoded) - 4, false);
+  hexSzs[1] = to_hex(hex1, ex1_encoded + 4, sizeof(ex1_encoded) - 4, false);
+  hexSzs[2] = to_hex(hex2, ex1_encoded + 4, sizeof(ex1_encoded) - 4, true);
+  hex1[10] = 'z';
+  const char * hexIns[3] = { hex, hex1, hex2 };
+  ABIItem_t items[8];
+  int counts[3];
+  int n = abi_decode_batch_hex( out, outSz, items, ARRAY_SIZE(items), ex1_abi, ARRAY_SIZE(ex1_abi), NULL, 
+                                hexIns, hexSzs, ARRAY_SIZE(hexIns), counts, 0, scratch, sizeof(scratch));
+  assert(n == 4);
+  assert(counts[0] == 2 && counts[1] == -1 && counts[2] == 2);
+  assert(items[2].payloadIdx == 2 && (bool) out[items[3].off] == ex1_param_1);
+  printf("passed.\n\r");
+}
+
+static inline void test_hex_encode(void) {
+  printf("Hex encoding...");
+  // Every length up to a few vectors' worth, to cover the kernel tails
+  uint8_t bytes[100];
+  char hex[2 + (2 * sizeof(bytes))];
+  char expected[2 + (2 * sizeof(bytes))];
+  for (size_t i = 0; i < sizeof(bytes); i++)
+    bytes[i] = (uint8_t) ((i * 37) + 11);
+  for (size_t n = 0; n <= sizeof(bytes); n++) {
+    size_t hexSz = to_hex(expected, bytes, n, false);
+    assert((int) hexSz == abi_hex_encode(hex, hexSz, bytes, n));
+    assert(0 == memcmp(hex, expected, hexSz));
+  }
+  assert(-1 == abi_hex_encode(hex, 2 + (2 * 10) - 1, bytes, 10));
+
+  // Whole encoded payloads round trip through the decoder
+  static char payloadHex[2 + (2 * sizeof(marketSellOrders_encoded))];
+  int hexSz = abi_hex_encode(payloadHex, sizeof(payloadHex), marketSellOrders_encoded, sizeof(marketSellOrders_encoded));
+  assert(hexSz == (int) sizeof(payloadHex));
+  static uint8_t payload[sizeof(marketSellOrders_encoded)];
+  assert((int) sizeof(payload) == abi_hex_decode(payload, sizeof(payload), payloadHex, hexSz));
+  assert(0 == memcmp(payload, marketSellOrders_encoded, sizeof(payload)));
+
+  // A column of addresses, with and without EIP-55 checksums (vectors from the EIP)
+  const char * checksummed[4] = {
+    "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed",
+    "0xfB6916095ca1df60bB79Ce92cE3Ea74c37c5d359",
+    "0xdbF03B407c01E7cD3CBea99509d93f8DDDC8C6FB",
+    "0xD1220A0cf47c7B9Be7A2E6BA89F429762e7b9aDb",
+  };
+  uint8_t addrs[4 * ABI_ADDRESS_SZ];
+  for (size_t i = 0; i < 4; i++)
+    assert(ABI_ADDRESS_SZ == abi_hex_decode(addrs + (i * ABI_ADDRESS_SZ), ABI_ADDRESS_SZ, checksummed[i], 42));
+  char column[4 * 42];
+  assert((int) sizeof(column) == abi_hex_encode_column(column, sizeof(column), addrs, ABI_ADDRESS_SZ, 4, ABI_HEX_CHECKSUM));
+  for (size_t i = 0; i < 4; i++)
+    assert(0 == memcmp(column + (i * 42), checksummed[i], 42));
+  assert((int) sizeof(column) == abi_hex_encode_column(column, sizeof(column), addrs, ABI_ADDRESS_SZ, 4, ABI_HEX_DEFAULT));
+  for (size_t i = 0; i < 4; i++) {
+    to_hex(expected, addrs + (i * ABI_ADDRESS_SZ), ABI_ADDRESS_SZ, false);
+    assert(0 == memcmp(column + (i * 42), expected, 42));
+  }
+  assert(-1 == abi_hex_encode_column(column, sizeof(column) - 1, addrs, ABI_ADDRESS_SZ, 4, ABI_HEX_DEFAULT));
+
+  // Checksums only apply to addresses; other sizes are left lowercase
+  char words[2 * 66];
+  assert((int) sizeof(words) == abi_hex_encode_column(words, sizeof(words), marketSellOrders_encoded + 4, 
+                                                      ABI_WORD_SZ, 2, ABI_HEX_CHECKSUM));
+  for (size_t i = 0; i < 2; i++) {
+    to_hex(expected, marketSellOrders_encoded + 4 + (i * ABI_WORD_SZ), ABI_WORD_SZ, false);
+    assert(0 == memcmp(words + (i * 66), expected, 66));
+  }
+  printf("passed.\n\r");
+}
+
+static inline void test_match_selectors(void) {
+  printf("Selector matching...");
+  // Known selectors fill both halves of the target set so each kernel lane is used
+  uint8_t selectors[ABI_MATCH_SELECTORS_MAX * ABI_SELECTOR_SZ];
+  for (size_t i = 0; i < sizeof(selectors); i++)
+    selectors[i] = (uint8_t) (0xa0 + i);
+  memcpy(selectors + (1 * ABI_SELECTOR_SZ), ex1_encoded, ABI_SELECTOR_SZ);
+  memcpy(selectors + (9 * ABI_SELECTOR_SZ), fillOrder_encoded, ABI_SELECTOR_SZ);
+  memcpy(selectors + (15 * ABI_SELECTOR_SZ), ex3_encoded, ABI_SELECTOR_SZ);
+  // A duplicate later in the set never wins
+  memcpy(selectors + (12 * ABI_SELECTOR_SZ), ex1_encoded, ABI_SELECTOR_SZ);
+  const void * ins[7] = { ex1_encoded, ex3_encoded, fillOrder_encoded, marketSellOrders_encoded, ex1_encoded, NULL, ex3_encoded };
+  size_t inSzs[7] = { sizeof(ex1_encoded), sizeof(ex3_encoded), sizeof(fillOrder_encoded), 
+                      sizeof(marketSellOrders_encoded), 3, 0, sizeof(ex3_encoded) };
+  int matches[7];
+  assert(4 == abi_match_selectors(matches, ins, inSzs, 7, selectors, ABI_MATCH_SELECTORS_MAX));
+  assert(matches[0] == 1 && matches[1] == 15 && matches[2] == 9 && matches[3] == -1);
+  assert(matches[4] == -1 && matches[5] == -1 && matches[6] == 15);
+
+  // Only the first `numSelectors` targets are considered
+  assert(2 == abi_match_selectors(matches, ins, inSzs, 7, selectors, 10));
+  assert(matches[0] == 1 && matches[1] == -1 && matches[2] == 9 && matches[6] == -1);
+  assert(0 == abi_match_selectors(matches, ins, inSzs, 7, selectors, 0));
+  assert(-1 == abi_match_selectors(matches, ins, inSzs, 7, selectors, ABI_MATCH_SELECTORS_MAX + 1));
+  printf("passed.\n\r");
+}
+
+// Reference statistics, one byte at a time
+static void get_expected_stats(ABICalldataStats_t * stats, const uint8_t * in, size_t inSz) {
+  memset(stats, 0, sizeof(ABICalldataStats_t));
+  bool prevZero = false;
+  for (size_t i = 0; i < inSz; i++)
+    stats->zeroBytes += (in[i] == 0);
+  for (size_t i = 0; i + ABI_WORD_SZ <= inSz; i += ABI_WORD_SZ) {
+    bool isZero = true;
+    for (size_t j = 0; j < ABI_WORD_SZ; j++)
+      isZero = isZero && (in[i + j] == 0);
+    stats->zeroWords += isZero;
+    stats->zeroWordRuns += (isZero && !prevZero);
+    prevZero = isZero;
+  }
+  stats->nonzeroBytes = inSz - stats->zeroBytes;
+  stats->gas = (4 * stats->zeroBytes) + (16 * stats->nonzeroBytes);
+}
+
+static inline void test_calldata_stats(uint8_t * out, size_t outSz) {
+  printf("Calldata stats...");
+  ABICalldataStats_t stats, expected;
+  // A hand checked payload: a selector, a zero word, an address word, and a run of 2 zero words
+  uint8_t payload[4 + (4 * ABI_WORD_SZ)] = { 0xa9, 0x05, 0x9c, 0xbb };
+  memset(payload + 4 + ABI_WORD_SZ + 12, 0x11, 20);
+  assert(0 == abi_calldata_stats(&stats, payload, sizeof(payload)));
+  assert(stats.zeroBytes == 108 && stats.nonzeroBytes == 24 && stats.gas == (108 * 4) + (24 * 16));
+  // Words are aligned to the start of what is scanned, so scan the params for their words
+  assert(0 == abi_calldata_stats(&stats, payload + 4, sizeof(payload) - 4));
+  assert(stats.zeroWords == 3 && stats.zeroWordRuns == 2);
+
+  // Patterns of zero and nonzero words at every length up to several kernel blocks
+  static uint8_t buf[12 * ABI_WORD_SZ];
+  uint32_t seed = 7;
+  for (size_t i = 0; i < sizeof(buf); i += ABI_WORD_SZ) {
+    seed = seed * 1103515245 + 12345;
+    if ((seed >> 16) % 3 == 0)
+      buf[i + ((seed >> 8) % ABI_WORD_SZ)] = (uint8_t) (seed | 1);
+  }
+  for (size_t n = 0; n <= sizeof(buf); n++) {
+    get_expected_stats(&expected, buf, n);
+    assert(0 == abi_calldata_stats(&stats, buf, n));
+    assert(0 == memcmp(&stats, &expected, sizeof(stats)));
+  }
+  get_expected_stats(&expected, fillOrder_encoded, sizeof(fillOrder_encoded));
+  assert(0 == abi_calldata_stats(&stats, fillOrder_encoded, sizeof(fillOrder_encoded)));
+  assert(0 == memcmp(&stats, &expected, sizeof(stats)));
+  assert(-1 == abi_calldata_stats(NULL, buf, sizeof(buf)));
+
+  // Encoders report the statistics of what they wrote
+  memset(out, 0, outSz);
+  int encSz = abi_encode_with_stats(out, outSz, enc_ex3_abi, ARRAY_SIZE(enc_ex3_abi), 
+                                    enc_ex3_offsets, enc_ex3_params, sizeof(enc_ex3_params), &stats);
+  assert(encSz == (int) sizeof(enc_ex3_encoded));
+  assert(0 == memcmp(out, enc_ex3_encoded, sizeof(enc_ex3_encoded)));
+  get_expected_stats(&expected, enc_ex3_encoded, sizeof(enc_ex3_encoded));
+  assert(0 == memcmp(&stats, &expected, sizeof(stats)));
+  // Calls include their selector bytes in the gas, but words are those of the params
+  ABIFunction_t fn;
+  assert(true == abi_compile_function(&fn, "f", enc_ex3_abi, ARRAY_SIZE(enc_ex3_abi)));
+  encSz = abi_encode_call_with_stats( out, outSz, &fn, enc_ex3_offsets, enc_ex3_params, 
+                                      sizeof(enc_ex3_params), &stats);
+  assert(encSz == (int) sizeof(enc_ex3_encoded) + ABI_SELECTOR_SZ);
+  get_expected_stats(&expected, out + ABI_SELECTOR_SZ, sizeof(enc_ex3_encoded));
+  size_t selectorZeros = 0;
+  for (size_t i = 0; i < ABI_SELECTOR_SZ; i++)
+    selectorZeros += (fn.selector[i] == 0);
+  assert(stats.zeroBytes == expected.zeroBytes + selectorZeros);
+  assert(stats.nonzeroBytes == expected.nonzeroBytes + ABI_SELECTOR_SZ - selectorZeros);
+  assert(stats.zeroWords == expected.zeroWords && stats.zeroWordRuns == expected.zeroWordRuns);
+  assert(stats.gas == expected.gas + (4 * selectorZeros) + (16 * (ABI_SELECTOR_SZ - selectorZeros)));
+  get_expected_stats(&expected, out, encSz);
+  assert(stats.gas == expected.gas);
+  memset(out, 0, outSz);
   printf("passed.\n\r");
 }
 
@@ -2110,10 +3921,8 @@ static inline void test_failures(uint8_t * out, size_t outSz) {
   printf("passed.\n\r");
 }
 
-int main() {
-  printf("=============================\n\r");
-  printf(" RUNNING ABI TESTS...\n\r");
-  printf("=============================\n\r");
+// Run every test against the current kernel variant
+static void run_tests(void) {
   uint8_t out[500] = {0};
   test_ex1(out, sizeof(out));
   test_ex2(out, sizeof(out));
@@ -2154,7 +3963,52 @@ int main() {
   test_tupleMulti13(out, sizeof(out));
   test_tupleMulti14(out, sizeof(out));
   test_enc(out, sizeof(out));
+  test_enc_arrays(out, sizeof(out));
+  test_enc_dynamic_arrays(out, sizeof(out));
+  test_enc_tuples();
+  test_enc_values();
+  test_template();
+  test_enc_setters();
+  test_functions();
+  test_patch_param();
+  test_packed();
+  test_walk(out, sizeof(out));
+  test_predicate();
+  test_u256_agg();
+  test_block();
+  test_array(out, sizeof(out));
+  test_strict(out, sizeof(out));
+  test_native_endian(out, sizeof(out));
+  test_bitset(out, sizeof(out));
+  test_uint_array(out, sizeof(out));
+  test_hex_decode(out, sizeof(out));
+  test_hex_encode();
+  test_match_selectors();
+  test_calldata_stats(out, sizeof(out));
   test_failures(out, sizeof(out));
+}
+
+int main() {
+  printf("=============================\n\r");
+  printf(" RUNNING ABI TESTS...\n\r");
+  printf("=============================\n\r");
+  // Every kernel variant must match the same expectations
+  const char * variantNames[] = { "auto", "scalar", "SSSE3", "AVX2" };
+  for (int v = ABI_KERNELS_SCALAR; v <= ABI_KERNELS_AVX2; v++) {
+    if (!abi_set_kernels((ABIKernelVariant_t) v)) {
+      printf("Skipping %s kernels (not supported)\n\r", variantNames[v]);
+      continue;
+    }
+    printf("----- %s kernels -----\n\r", variantNames[v]);
+    run_tests();
+  }
+  // The environment override is honored when the variant is detected
+  setenv("ABI_FORCE_SCALAR", "1", 1);
+  assert(abi_set_kernels(ABI_KERNELS_AUTO));
+  assert(abi_get_kernels() == ABI_KERNELS_SCALAR);
+  unsetenv("ABI_FORCE_SCALAR");
+  assert(abi_set_kernels(ABI_KERNELS_AUTO));
+  assert(abi_get_kernels() != ABI_KERNELS_AUTO);
 
   printf("=============================\n\r");
   printf(" ALL ABI TESTS PASSING!\n\r");